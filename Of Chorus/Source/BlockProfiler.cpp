@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    BlockProfiler.cpp
+
+  ==============================================================================
+*/
+
+#include "BlockProfiler.h"
+
+#if OF_CHORUS_PROFILING
+
+//==============================================================================
+BlockProfiler::BlockProfiler()
+{
+    for(auto& bin : mBins) {
+        bin = 0;
+    }
+    
+    for(auto& entry : mHistory) {
+        entry.microseconds = 0.0f;
+        entry.load = 0.0f;
+        entry.numSamples = 0;
+    }
+    
+    mNumBlocks = 0;
+    mMinLoad = 0.0f;
+    mMaxLoad = 0.0f;
+    mHistoryWritePosition = 0;
+    mResetRequested = false;
+}
+
+BlockProfiler::ScopedBlock::ScopedBlock(BlockProfiler& profiler, int numSamples, double sampleRate)
+    : mProfiler(profiler)
+{
+    mNumSamples = numSamples;
+    mSampleRate = sampleRate;
+    mStart = std::chrono::steady_clock::now();
+}
+
+BlockProfiler::ScopedBlock::~ScopedBlock()
+{
+    const auto end = std::chrono::steady_clock::now();
+    mProfiler.record(std::chrono::duration<double>(end - mStart).count(), mNumSamples, mSampleRate);
+}
+
+void BlockProfiler::record(double seconds, int numSamples, double sampleRate)
+{
+    if(numSamples <= 0 || sampleRate <= 0.0) {
+        return;
+    }
+    
+    if(mResetRequested.exchange(false, std::memory_order_relaxed)) {
+        for(auto& bin : mBins) {
+            bin.store(0, std::memory_order_relaxed);
+        }
+        
+        // The ring starts over too, toCSV only reads as many entries as there are blocks since the reset
+        mNumBlocks.store(0, std::memory_order_relaxed);
+        mMinLoad.store(0.0f, std::memory_order_relaxed);
+        mMaxLoad.store(0.0f, std::memory_order_relaxed);
+        mHistoryWritePosition.store(0, std::memory_order_relaxed);
+    }
+    
+    const float load = (float) (100.0 * seconds * sampleRate / numSamples);
+    const auto numBlocks = mNumBlocks.load(std::memory_order_relaxed);
+    
+    // Only this thread writes, so plain loads and stores are enough for the extremes
+    if(numBlocks == 0 || load < mMinLoad.load(std::memory_order_relaxed)) {
+        mMinLoad.store(load, std::memory_order_relaxed);
+    }
+    
+    if(numBlocks == 0 || load > mMaxLoad.load(std::memory_order_relaxed)) {
+        mMaxLoad.store(load, std::memory_order_relaxed);
+    }
+    
+    const int bin = juce::jlimit(0, numBins - 1, (int) (load / binWidth));
+    mBins[bin].fetch_add(1, std::memory_order_relaxed);
+    
+    const int position = mHistoryWritePosition.load(std::memory_order_relaxed);
+    mHistory[position].microseconds.store((float) (seconds * 1.0e6), std::memory_order_relaxed);
+    mHistory[position].load.store(load, std::memory_order_relaxed);
+    mHistory[position].numSamples.store(numSamples, std::memory_order_relaxed);
+    mHistoryWritePosition.store((position + 1) % historySize, std::memory_order_relaxed);
+    
+    // Published last, so a reader never counts a block it cannot see yet
+    mNumBlocks.store(numBlocks + 1, std::memory_order_release);
+}
+
+BlockProfiler::Stats BlockProfiler::getStats() const
+{
+    Stats stats;
+    stats.numBlocks = mNumBlocks.load(std::memory_order_acquire);
+    stats.minLoad = mMinLoad.load(std::memory_order_relaxed);
+    stats.maxLoad = mMaxLoad.load(std::memory_order_relaxed);
+    
+    // A bin's upper edge can lie past the slowest block that landed in it
+    stats.medianLoad = juce::jmin(stats.maxLoad, getLoadAtRank(stats.numBlocks / 2));
+    stats.p99Load = juce::jmin(stats.maxLoad, getLoadAtRank(stats.numBlocks * 99 / 100));
+    
+    return stats;
+}
+
+float BlockProfiler::getLoadAtRank(juce::int64 rank) const
+{
+    juce::int64 count = 0;
+    
+    // Reporting the upper edge of the bin the rank falls into
+    for(int bin = 0; bin < numBins; bin++) {
+        count += mBins[bin].load(std::memory_order_relaxed);
+        
+        if(count > rank) {
+            return (float) (bin + 1) * binWidth;
+        }
+    }
+    
+    return (float) numBins * binWidth;
+}
+
+juce::String BlockProfiler::toCSV() const
+{
+    juce::String csv;
+    const auto stats = getStats();
+    const int numEntries = (int) juce::jmin((juce::int64) historySize, stats.numBlocks);
+    const int end = mHistoryWritePosition.load(std::memory_order_relaxed);
+    
+    csv << "block,num_samples,microseconds,load_percent\n";
+    
+    for(int i = 0; i < numEntries; i++) {
+        const auto& entry = mHistory[(end - numEntries + i + historySize) % historySize];
+        
+        csv << i << "," << entry.numSamples.load(std::memory_order_relaxed) << ","
+            << entry.microseconds.load(std::memory_order_relaxed) << ","
+            << entry.load.load(std::memory_order_relaxed) << "\n";
+    }
+    
+    csv << "\nload_from_percent,load_to_percent,num_blocks\n";
+    
+    for(int bin = 0; bin < numBins; bin++) {
+        csv << (float) bin * binWidth << "," << (float) (bin + 1) * binWidth << "," << (int) mBins[bin].load(std::memory_order_relaxed) << "\n";
+    }
+    
+    csv << "\nblocks,min_percent,median_percent,p99_percent,max_percent\n"
+        << stats.numBlocks << "," << stats.minLoad << "," << stats.medianLoad << "," << stats.p99Load << "," << stats.maxLoad << "\n";
+    
+    return csv;
+}
+
+#endif
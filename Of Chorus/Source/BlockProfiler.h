@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    BlockProfiler.h
+
+    Times every processBlock call against its deadline, the duration of the
+    audio it covers, and keeps the results in a fixed size histogram and a
+    ring of the most recent blocks. The audio thread only ever does relaxed
+    atomic stores and increments, the editor reads the statistics and the
+    ring from the message thread.
+
+    Compiled in unless OF_CHORUS_PROFILING is 0, in which case the processor
+    holds no profiler and processBlock reads no clock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <chrono>
+
+#ifndef OF_CHORUS_PROFILING
+ #define OF_CHORUS_PROFILING 1
+#endif
+
+#if OF_CHORUS_PROFILING
+
+//==============================================================================
+/**
+*/
+class BlockProfiler
+{
+public:
+    BlockProfiler();
+
+    /** Load is the time spent in a block as a percentage of its deadline. */
+    struct Stats
+    {
+        juce::int64 numBlocks;
+        float minLoad;
+        float medianLoad;
+        float p99Load;
+        float maxLoad;
+    };
+
+    /** Times the enclosing scope and records it as one block, on the audio thread. */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(BlockProfiler& profiler, int numSamples, double sampleRate);
+        ~ScopedBlock();
+
+    private:
+        BlockProfiler& mProfiler;
+        int mNumSamples;
+        double mSampleRate;
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+    void record(double seconds, int numSamples, double sampleRate);
+
+    /** Median and p99 come from the histogram, so they are exact to one bin. */
+    Stats getStats() const;
+
+    /** Asks the audio thread to drop the statistics and the ring and start over with its next block. */
+    void reset() { mResetRequested = true; }
+
+    /** The most recent blocks, oldest first, plus the histogram. */
+    juce::String toCSV() const;
+
+    static constexpr float binWidth = 1.0f;
+    /** The last bin also collects every block beyond it. */
+    static constexpr int numBins = 200;
+    static constexpr int historySize = 4096;
+
+private:
+    float getLoadAtRank(juce::int64 rank) const;
+
+    std::atomic<juce::uint32> mBins[numBins];
+    std::atomic<juce::int64> mNumBlocks;
+    std::atomic<float> mMinLoad;
+    std::atomic<float> mMaxLoad;
+
+    struct Entry
+    {
+        std::atomic<float> microseconds;
+        std::atomic<float> load;
+        std::atomic<int> numSamples;
+    };
+
+    Entry mHistory[historySize];
+    std::atomic<int> mHistoryWritePosition;
+
+    std::atomic<bool> mResetRequested;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockProfiler)
+};
+
+#endif
@@ -0,0 +1,1146 @@
+/*
+  ==============================================================================
+
+    ChorusKernel.cpp
+
+  ==============================================================================
+*/
+
+#include "ChorusKernel.h"
+
+//==============================================================================
+ChorusKernel::ChorusKernel()
+{
+    mSampleRate = 44100.0;
+
+    mNumChannels = 0;
+    mNumVoices = 0;
+    mType = -1;
+    mNumTaps = 0;
+    mNumTapGroups = 0;
+
+    for(int tap = 0; tap < maxTaps; tap++) {
+        mTapChannel[tap] = 0;
+        mTapPhase[tap] = 0;
+    }
+
+    for(int channel = 0; channel < maxChannels; channel++) {
+        mFeedback[channel] = 0;
+    }
+
+    mInterpolation = InterpolationType::linear;
+    mMaxTapSwing = 0;
+    mMinTapDelay = 0;
+    mRotatingOffsets = false;
+
+    for(int group = 0; group < maxTapGroups; group++) {
+        mInterpolatorState[group] = Vec::expand(0.0f);
+        mTapDelay[group] = Vec::expand(0.0f);
+        mTapDelayTarget[group] = Vec::expand(0.0f);
+        mTapDelayStep[group] = Vec::expand(0.0f);
+    }
+
+    mTapDelaysValid = false;
+    mNextControlPoint = 0;
+    mControlInterval = defaultControlInterval;
+    mChunkControlInterval = 1;
+
+    mLFOValue = 0;
+    mChunkPosition = 0;
+    mChunkStart = 0;
+    mChunkPrepared = false;
+    mChunkHasDry = true;
+    mChunkHasWet = true;
+    mChunkHasFeedback = true;
+
+    mChunkHasEnvelopeDepth = false;
+    mChunkHasEnvelopeMix = false;
+    mEnvelopeLevels = nullptr;
+    mFirstEnvelopeBoundary = 0;
+    mHeldEnvelopeLevel = 0;
+    mChunkBlockOffset = 0;
+    mEnvelopeMixEnd = 0;
+
+    mEngine = Engine::block;
+
+    for(int channel = 0; channel < maxChannels; channel++) {
+        juce::FloatVectorOperations::clear(mWindowWet[channel], maxBlockWindow);
+    }
+
+    mDelayLineWriteHead = 0;
+
+    mQuietSamples = 0;
+    mIdle = false;
+}
+
+void ChorusKernel::prepare(double sampleRate, int numChannels)
+{
+    jassert(numChannels <= maxChannels);
+
+    mSampleRate = sampleRate;
+    mLFO.prepare(sampleRate);
+
+    mDryWet.reset(sampleRate, smoothingTimeSeconds);
+    mDepth.reset(sampleRate, smoothingTimeSeconds);
+    mRate.reset(sampleRate, smoothingTimeSeconds);
+    mPhaseOffset.reset(sampleRate, smoothingTimeSeconds);
+    mFeedbackAmount.reset(sampleRate, smoothingTimeSeconds);
+
+    mEnvelopeDepth.reset(sampleRate, smoothingTimeSeconds);
+    mEnvelopeRate.reset(sampleRate, smoothingTimeSeconds);
+    mEnvelopeMix.reset(sampleRate, smoothingTimeSeconds);
+
+    // Leaving room for the widest interpolator's points past the longest delay
+    mDelayLine.prepare(juce::jlimit(1, maxChannels, numChannels), (int) std::ceil(sampleRate * maxDelaySeconds) + maxInterpolationPoints);
+
+    // Forcing the taps to be laid out again for the new sample rate
+    mNumTaps = 0;
+
+    reset();
+}
+
+void ChorusKernel::reset()
+{
+    mLFO.reset();
+
+    for(int channel = 0; channel < maxChannels; channel++) {
+        mFeedback[channel] = 0;
+    }
+
+    for(int group = 0; group < maxTapGroups; group++) {
+        mInterpolatorState[group] = Vec::expand(0.0f);
+    }
+
+    mDelayLine.clear();
+    mDelayLineWriteHead = 0;
+
+    mQuietSamples = 0;
+    mIdle = false;
+
+    // Counting chunks from here, and starting the delay ramps from the LFO's first value
+    mLFOValue = 0;
+    mChunkPosition = 0;
+    mChunkPrepared = false;
+    mTapDelaysValid = false;
+    mHeldEnvelopeLevel = 0;
+
+    // Jumping straight to the next snapshot instead of ramping from stale values
+    mSnapParameters = true;
+}
+
+void ChorusKernel::fillRamp(juce::SmoothedValue<float>& value, float* ramp, int numSamples)
+{
+    if(! value.isSmoothing()) {
+        juce::FloatVectorOperations::fill(ramp, value.getTargetValue(), numSamples);
+        return;
+    }
+
+    for(int i = 0; i < numSamples; i++) {
+        ramp[i] = value.getNextValue();
+    }
+}
+
+void ChorusKernel::updateTaps(int numChannels, int numVoices, int type)
+{
+    if(numChannels == mNumChannels && numVoices == mNumVoices && type == mType && mNumTaps > 0) {
+        return;
+    }
+
+    mNumChannels = numChannels;
+    mNumVoices = numVoices;
+    mType = type;
+    mNumTaps = numChannels * numVoices;
+    mNumTapGroups = (mNumTaps + lanes - 1) / lanes;
+
+    // jmap(lfo * depth, -1, 1, min, max) * sampleRate folded into one multiply-add
+    float minDelay, maxDelay;
+    getDelayRange(type, minDelay, maxDelay);
+
+    const float delayCentre = (float) mSampleRate * (minDelay + maxDelay) * 0.5f;
+    const float delaySwing = (float) mSampleRate * (maxDelay - minDelay) * 0.5f;
+
+    alignas(Vec::SIMDRegisterSize) float centres[maxTapGroups * lanes] = {};
+    alignas(Vec::SIMDRegisterSize) float swings[maxTapGroups * lanes] = {};
+    alignas(Vec::SIMDRegisterSize) float gains[maxTapGroups * lanes] = {};
+
+    mMaxTapSwing = 0;
+    mMinTapDelay = delayCentre * maxVoiceDelayScale;
+
+    for(int tap = 0; tap < mNumTaps; tap++) {
+        const int voice = tap % numVoices;
+
+        // Spreading the voices evenly over the LFO cycle and over the delay scale range,
+        // a single voice keeps the original delay times
+        const float spread = numVoices > 1 ? (float) voice / (float) (numVoices - 1) : 0.5f;
+        const float delayScale = juce::jmap(spread, minVoiceDelayScale, maxVoiceDelayScale);
+
+        mTapChannel[tap] = tap / numVoices;
+        mTapPhase[tap] = (float) voice / (float) numVoices;
+
+        centres[tap] = delayCentre * delayScale;
+        swings[tap] = delaySwing * delayScale;
+        mMaxTapSwing = juce::jmax(mMaxTapSwing, swings[tap]);
+        mMinTapDelay = juce::jmin(mMinTapDelay, centres[tap] - swings[tap]);
+        gains[tap] = 1.0f / (float) numVoices;
+    }
+
+    // Unused lanes keep a valid delay and a gain of zero
+    for(int tap = mNumTaps; tap < mNumTapGroups * lanes; tap++) {
+        centres[tap] = delayCentre;
+    }
+
+    for(int group = 0; group < mNumTapGroups; group++) {
+        mTapDelayCentre[group] = Vec::fromRawArray(centres + group * lanes);
+        mTapDelaySwing[group] = Vec::fromRawArray(swings + group * lanes);
+        mTapGain[group] = Vec::fromRawArray(gains + group * lanes);
+        mInterpolatorState[group] = Vec::expand(0.0f);
+    }
+
+    getTapPhaseOffsets(mPhaseOffset.getCurrentValue(), mTapOffsetCos, mTapOffsetSin);
+    mTapDelaysValid = false;
+}
+
+void ChorusKernel::setControlInterval(int numSamples)
+{
+    mControlInterval = juce::jlimit(1, maxControlInterval, numSamples);
+}
+
+void ChorusKernel::getDelayRange(int type, float& minDelay, float& maxDelay)
+{
+    switch((EffectType) type) {
+        case EffectType::flanger:
+            minDelay = 0.001f;
+            maxDelay = 0.005f;
+            break;
+        case EffectType::vibrato:
+            minDelay = 0.002f;
+            maxDelay = 0.008f;
+            break;
+        case EffectType::doubler:
+            // A static delay, the voices only spread it over the delay scale range
+            minDelay = 0.02f;
+            maxDelay = 0.02f;
+            break;
+        case EffectType::chorus:
+        default:
+            minDelay = 0.005f;
+            maxDelay = 0.03f;
+            break;
+    }
+}
+
+ChorusKernel::Parameters ChorusKernel::applyEffectType(Parameters parameters)
+{
+    if(parameters.type == (int) EffectType::vibrato) {
+        parameters.dryWet = 1.0f;
+        parameters.feedback = 0.0f;
+        parameters.envelopeMix = 0.0f;
+    }
+    else if(parameters.type == (int) EffectType::doubler) {
+        parameters.feedback = 0.0f;
+    }
+
+    return parameters;
+}
+
+double ChorusKernel::getTailLengthSeconds(const Parameters& parameters)
+{
+    float minDelay, maxDelay;
+    getDelayRange(parameters.type, minDelay, maxDelay);
+
+    // A single voice keeps the mode's delay times, more voices stretch up to the widest scale
+    const double longestDelay = maxDelay * (parameters.voices > 1 ? maxVoiceDelayScale : 1.0f);
+
+    // Every trip around the loop takes at most the longest delay and scales the signal by the feedback
+    double numTrips = 0;
+
+    if(parameters.feedback > 0) {
+        numTrips = std::ceil(std::log((double) silenceThreshold) / std::log((double) juce::jmin(parameters.feedback, 0.9999f)));
+    }
+
+    return longestDelay * (1.0 + numTrips);
+}
+
+template <typename SampleType>
+bool ChorusKernel::isSilent(SampleType* const* channels, int numChannels, int numSamples)
+{
+    for(int channel = 0; channel < numChannels; channel++) {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(channels[channel], numSamples);
+
+        if(juce::jmax(-range.getStart(), range.getEnd()) >= (SampleType) silenceThreshold) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ChorusKernel::getTapPhaseOffsets(float phaseOffset, Vec* offsetCos, Vec* offsetSin) const
+{
+    // Channel 0 runs at the LFO phase and the last channel is offset by the phase offset parameter,
+    // the channels in between are spread evenly, so stereo gets the full offset on the right.
+    // Every voice is offset further by its spread. Each offset is a rotation of the LFO's (sin, cos) pair.
+    alignas(Vec::SIMDRegisterSize) float cosLanes[maxTapGroups * lanes] = {};
+    alignas(Vec::SIMDRegisterSize) float sinLanes[maxTapGroups * lanes] = {};
+
+    const float channelSpread = mNumChannels > 1 ? phaseOffset / (float) (mNumChannels - 1) : 0.0f;
+
+    for(int tap = 0; tap < mNumTaps; tap++) {
+        const float offset = mTapPhase[tap] + channelSpread * (float) mTapChannel[tap];
+
+        cosLanes[tap] = std::cos(juce::MathConstants<float>::twoPi * offset);
+        sinLanes[tap] = std::sin(juce::MathConstants<float>::twoPi * offset);
+    }
+
+    for(int group = 0; group < mNumTapGroups; group++) {
+        offsetCos[group] = Vec::fromRawArray(cosLanes + group * lanes);
+        offsetSin[group] = Vec::fromRawArray(sinLanes + group * lanes);
+    }
+}
+
+template <typename SampleType>
+void ChorusKernel::process(SampleType* const* channels, int numChannels, int numSamples, const Parameters& parameters,
+                           const float* envelopeLevels, int firstEnvelopeBoundary)
+{
+    numChannels = juce::jmin(numChannels, mDelayLine.getNumChannels());
+
+    if(numChannels == 0 || mDelayLine.getLength() == 0) {
+        return;
+    }
+
+    if(mSnapParameters) {
+        mDryWet.setCurrentAndTargetValue(parameters.dryWet);
+        mDepth.setCurrentAndTargetValue(parameters.depth);
+        mRate.setCurrentAndTargetValue(parameters.rate);
+        mPhaseOffset.setCurrentAndTargetValue(parameters.phaseOffset);
+        mFeedbackAmount.setCurrentAndTargetValue(parameters.feedback);
+
+        mEnvelopeDepth.setCurrentAndTargetValue(parameters.envelopeDepth);
+        mEnvelopeRate.setCurrentAndTargetValue(parameters.envelopeRate);
+        mEnvelopeMix.setCurrentAndTargetValue(parameters.envelopeMix);
+
+        mNumTaps = 0;
+        mSnapParameters = false;
+    }
+    else {
+        mDryWet.setTargetValue(parameters.dryWet);
+        mDepth.setTargetValue(parameters.depth);
+        mRate.setTargetValue(parameters.rate);
+        mPhaseOffset.setTargetValue(parameters.phaseOffset);
+        mFeedbackAmount.setTargetValue(parameters.feedback);
+
+        mEnvelopeDepth.setTargetValue(parameters.envelopeDepth);
+        mEnvelopeRate.setTargetValue(parameters.envelopeRate);
+        mEnvelopeMix.setTargetValue(parameters.envelopeMix);
+    }
+
+    // The levels are only read during this call, whatever the last of them is holds after it
+    mEnvelopeLevels = envelopeLevels;
+    mFirstEnvelopeBoundary = firstEnvelopeBoundary;
+
+    if(envelopeLevels != nullptr) {
+        mHeldEnvelopeLevel = envelopeLevels[getEnvelopeSegment(numSamples - 1) + 1];
+    }
+
+    const int numVoices = juce::jlimit(1, maxVoices, parameters.voices);
+    const auto interpolation = (InterpolationType) juce::jlimit(0, numInterpolationTypes - 1, parameters.interpolation);
+    const bool silentInput = isSilent(channels, numChannels, numSamples);
+
+    if(mIdle) {
+        if(silentInput) {
+            processIdle(channels, numChannels, numSamples);
+            return;
+        }
+
+        mIdle = false;
+    }
+
+    // New voices, a new type or a new interpolator take over where the next chunk starts, so no
+    // chunk is rendered with two tap layouts. What is left of the current one keeps the old ones
+    const bool modesChanged = mNumTaps == 0 || numChannels != mNumChannels || numVoices != mNumVoices
+                           || parameters.type != mType || interpolation != mInterpolation;
+    int startSample = 0;
+
+    if(modesChanged && mChunkPrepared && mNumTaps > 0) {
+        startSample = juce::jmin(numSamples, chunkSize - mChunkPosition);
+        processWithInterpolator(channels, numChannels, 0, startSample);
+    }
+
+    if(startSample < numSamples) {
+        updateTaps(numChannels, numVoices, parameters.type);
+        setInterpolation(interpolation);
+        processWithInterpolator(channels, numChannels, startSample, numSamples);
+    }
+
+    if(silentInput) {
+        updateSilence(numSamples);
+    }
+    else {
+        mQuietSamples = 0;
+    }
+}
+
+void ChorusKernel::setInterpolation(InterpolationType interpolation)
+{
+    if(interpolation == mInterpolation) {
+        return;
+    }
+
+    // The allpass state of the previous interpolator means nothing to the next one
+    for(int group = 0; group < maxTapGroups; group++) {
+        mInterpolatorState[group] = Vec::expand(0.0f);
+    }
+
+    mInterpolation = interpolation;
+}
+
+template <typename SampleType>
+void ChorusKernel::processWithInterpolator(SampleType* const* channels, int numChannels, int startSample, int endSample)
+{
+    // Picking the interpolator once per call, the loops below are specialised for it
+    switch(mInterpolation) {
+        case InterpolationType::lagrange:
+            processChunks<SampleType, LagrangeInterpolator>(channels, numChannels, startSample, endSample);
+            break;
+        case InterpolationType::allpass:
+            processChunks<SampleType, AllpassInterpolator>(channels, numChannels, startSample, endSample);
+            break;
+        case InterpolationType::sinc:
+            processChunks<SampleType, SincInterpolator>(channels, numChannels, startSample, endSample);
+            break;
+        case InterpolationType::linear:
+        default:
+            processChunks<SampleType, LinearInterpolator>(channels, numChannels, startSample, endSample);
+            break;
+    }
+}
+
+void ChorusKernel::updateSilence(int numSamples)
+{
+    // With silent input everything written this block came from the feedback path,
+    // and the frames written are contiguous in the interleaved line apart from one wrap
+    const int length = mDelayLine.getLength();
+    const int stride = mDelayLine.getNumChannels();
+    const int numFrames = juce::jmin(numSamples, length);
+    const int firstFrame = (mDelayLineWriteHead - numFrames) & mDelayLine.getMask();
+    const int numFramesBeforeWrap = juce::jmin(numFrames, length - firstFrame);
+
+    const auto before = juce::FloatVectorOperations::findMinAndMax(mDelayLine.getFrame(firstFrame), numFramesBeforeWrap * stride);
+    const auto after = juce::FloatVectorOperations::findMinAndMax(mDelayLine.getFrame(0), (numFrames - numFramesBeforeWrap) * stride);
+
+    const float peak = juce::jmax(-before.getStart(), before.getEnd(), -after.getStart(), after.getEnd());
+
+    if(peak >= silenceThreshold) {
+        mQuietSamples = 0;
+        return;
+    }
+
+    mQuietSamples += numSamples;
+
+    // Once a whole delay line of quiet samples has been written, nothing audible can come back out
+    if(mQuietSamples >= length) {
+        for(int channel = 0; channel < maxChannels; channel++) {
+            mFeedback[channel] = 0;
+        }
+
+        for(int group = 0; group < maxTapGroups; group++) {
+            mInterpolatorState[group] = Vec::expand(0.0f);
+        }
+
+        mDelayLine.clear();
+        mIdle = true;
+    }
+}
+
+template <typename SampleType>
+void ChorusKernel::processIdle(SampleType* const* channels, int numChannels, int numSamples)
+{
+    // Only keeping the modulation, the ramps, the chunk grid and the write head moving,
+    // so the effect picks up where it would have been when the input returns
+    int numSkipped = numSamples;
+
+    // What is left of a chunk that was already rendered only has to be passed over
+    if(mChunkPrepared) {
+        const int numRendered = juce::jmin(numSamples, chunkSize - mChunkPosition);
+
+        mChunkPosition += numRendered;
+        numSkipped -= numRendered;
+
+        if(numRendered > 0) {
+            mLFOValue = mLFOSin[mChunkPosition - 1];
+        }
+
+        if(mChunkPosition == chunkSize) {
+            finishTapRotation();
+            mChunkPosition = 0;
+            mChunkPrepared = false;
+        }
+    }
+
+    if(numSkipped > 0) {
+        mChunkBlockOffset = numSamples - numSkipped - mChunkPosition;
+        mLFO.setRate(getModulatedRate(mChunkPosition));
+        mRate.skip(numSkipped);
+        mLFO.skip(numSkipped);
+        mLFOValue = mLFO.getPreviousSin();
+
+        mDepth.skip(numSkipped);
+        mFeedbackAmount.skip(numSkipped);
+        mDryWet.skip(numSkipped);
+
+        mEnvelopeDepth.skip(numSkipped);
+        mEnvelopeRate.skip(numSkipped);
+        mEnvelopeMix.skip(numSkipped);
+
+        if(mPhaseOffset.isSmoothing()) {
+            getTapPhaseOffsets(mPhaseOffset.skip(numSkipped), mTapOffsetCos, mTapOffsetSin);
+        }
+
+        // The chunk the input returns in is rendered from there on
+        mChunkPosition = (mChunkPosition + numSkipped) % chunkSize;
+    }
+
+    // The delay line is empty, so the output is the dry part of the (silent) input
+    const SampleType dryAmount = (SampleType) (1.0f - mDryWet.getCurrentValue());
+
+    for(int channel = 0; channel < numChannels; channel++) {
+        juce::FloatVectorOperations::multiply(channels[channel], dryAmount, numSamples);
+    }
+
+    mDelayLineWriteHead = (mDelayLineWriteHead + numSamples) & mDelayLine.getMask();
+    mTapDelaysValid = false;
+}
+
+template <typename SampleType, typename Interpolator>
+void ChorusKernel::processChunks(SampleType* const* channels, int numChannels, int startSample, int endSample)
+{
+    // The block engine needs windows of at least a register's worth of samples to pay off,
+    // and a single tap with a short interpolator is still cheaper on its scalar path
+    const int windowSize = getBlockWindow<Interpolator>();
+    const bool block = mEngine == Engine::block && ! Interpolator::usesState && windowSize >= lanes
+                    && (mNumTaps > 1 || Interpolator::numPoints > LagrangeInterpolator::numPoints);
+
+    while(startSample < endSample) {
+        // A block that ends inside a chunk leaves the rest of it, as it was rendered, for the next block
+        mChunkBlockOffset = startSample - mChunkPosition;
+
+        if(! mChunkPrepared) {
+            prepareChunk();
+        }
+
+        const int numChunkSamples = juce::jmin(chunkSize - mChunkPosition, endSample - startSample);
+        const bool hasDry = mChunkHasDry;
+        const bool hasWet = mChunkHasWet;
+        const bool hasFeedback = mChunkHasFeedback;
+
+        // The allpass has to keep reading its taps to keep its state, so it never skips them
+        if(! hasWet && ! hasFeedback && ! Interpolator::usesState) {
+            processChunkDry(channels, numChannels, startSample, numChunkSamples);
+        }
+        else if(! hasWet) {
+            processChunkPaths<SampleType, Interpolator, SignalPaths<true, false, true>>(channels, numChannels, startSample, numChunkSamples, windowSize, block);
+        }
+        else if(! hasDry && hasFeedback) {
+            processChunkPaths<SampleType, Interpolator, SignalPaths<false, true, true>>(channels, numChannels, startSample, numChunkSamples, windowSize, block);
+        }
+        else if(! hasDry) {
+            processChunkPaths<SampleType, Interpolator, SignalPaths<false, true, false>>(channels, numChannels, startSample, numChunkSamples, windowSize, block);
+        }
+        else if(hasFeedback) {
+            processChunkPaths<SampleType, Interpolator, SignalPaths<true, true, true>>(channels, numChannels, startSample, numChunkSamples, windowSize, block);
+        }
+        else {
+            processChunkPaths<SampleType, Interpolator, SignalPaths<true, true, false>>(channels, numChannels, startSample, numChunkSamples, windowSize, block);
+        }
+
+        startSample += numChunkSamples;
+        mChunkPosition += numChunkSamples;
+        mLFOValue = mLFOSin[mChunkPosition - 1];
+
+        if(mChunkPosition == chunkSize) {
+            finishTapRotation();
+            mChunkPosition = 0;
+            mChunkPrepared = false;
+        }
+    }
+}
+
+template <typename SampleType, typename Interpolator, typename Paths>
+void ChorusKernel::processChunkPaths(SampleType* const* channels, int numChannels, int startSample, int numSamples, int windowSize, bool block)
+{
+    if(block) {
+        processChunkBlock<SampleType, Interpolator, Paths>(channels, numChannels, startSample, numSamples, windowSize);
+    }
+    else if(mNumTaps == 1) {
+        processChunkMono<SampleType, Interpolator, Paths>(channels[0], startSample, numSamples);
+    }
+    else {
+        processChunk<SampleType, Interpolator, Paths>(channels, numChannels, startSample, numSamples);
+    }
+}
+
+template <typename SampleType>
+void ChorusKernel::processChunkDry(SampleType* const* channels, int numChannels, int startSample, int numSamples)
+{
+    // Nothing is read back, so the delays start again from the LFO wherever the taps are read next
+    mTapDelaysValid = false;
+
+    // The output is the input untouched, it only has to go into the line for later chunks
+    const int mask = mDelayLine.getMask();
+    const int stride = mDelayLine.getNumChannels();
+    float* const delayData = mDelayLine.getFrame(0);
+
+    for(int channel = 0; channel < numChannels; channel++) {
+        const SampleType* const samples = channels[channel] + startSample;
+
+        for(int j = 0; j < numSamples; j++) {
+            delayData[((mDelayLineWriteHead + j) & mask) * stride + channel] = (float) samples[j];
+        }
+
+        mFeedback[channel] = 0;
+    }
+
+    mDelayLineWriteHead = (mDelayLineWriteHead + numSamples) & mask;
+}
+
+void ChorusKernel::prepareChunk()
+{
+    mChunkHasEnvelopeDepth = mEnvelopeDepth.isSmoothing() || ! juce::exactlyEqual(mEnvelopeDepth.getTargetValue(), 0.0f);
+    mChunkHasEnvelopeMix = mEnvelopeMix.isSmoothing() || ! juce::exactlyEqual(mEnvelopeMix.getTargetValue(), 0.0f);
+
+    // Picking the signal paths from where the mix and feedback sit, a ramp or the envelope needs all of them
+    mChunkHasDry = mChunkHasEnvelopeMix || mDryWet.isSmoothing() || mDryWet.getTargetValue() < 1.0f;
+    mChunkHasWet = mChunkHasEnvelopeMix || mDryWet.isSmoothing() || mDryWet.getTargetValue() > 0.0f;
+    mChunkHasFeedback = mFeedbackAmount.isSmoothing() || mFeedbackAmount.getTargetValue() > 0.0f;
+
+    // Rendering the LFO and the parameter ramps for the rest of the chunk up front,
+    // which is all of it unless the input came back from silence inside it
+    const int start = mChunkPosition;
+    const int numSamples = chunkSize - start;
+
+    const float rate = getModulatedRate(start);
+    mLFO.setRate(rate);
+    mRate.skip(numSamples);
+    mEnvelopeRate.skip(numSamples);
+    mLFO.process(mLFOSin + start, mLFOCos + start, numSamples);
+
+    fillRamp(mDryWet, mDryWetRamp + start, numSamples);
+    fillRamp(mDepth, mDepthRamp + start, numSamples);
+    fillRamp(mFeedbackAmount, mFeedbackRamp + start, numSamples);
+    fillRamp(mEnvelopeDepth, mEnvelopeDepthRamp + start, numSamples);
+    fillRamp(mEnvelopeMix, mEnvelopeMixRamp + start, numSamples);
+
+    // The last control point of the chunk sits on the first sample of the next one
+    mLFOSin[chunkSize] = mLFO.getNextSin();
+    mLFOCos[chunkSize] = mLFO.getNextCos();
+    mDepthRamp[chunkSize] = mDepthRamp[chunkSize - 1];
+    mEnvelopeDepthRamp[chunkSize] = mEnvelopeDepthRamp[chunkSize - 1];
+
+    mChunkStart = start;
+    mChunkControlInterval = getChunkControlInterval(rate);
+    prepareTapRotation();
+
+    // The ramps of the previous chunk end on its first sample
+    mNextControlPoint = start;
+    mEnvelopeMixEnd = start;
+    mChunkPrepared = true;
+}
+
+int ChorusKernel::getChunkControlInterval(float rate) const
+{
+    // A straight line over K samples misses a sine of amplitude A and angular rate w
+    // by at most A * (w * K)^2 / 8, so K is kept as long as that stays within tolerance
+    const double w = juce::MathConstants<double>::twoPi * rate / mSampleRate;
+    double depth = juce::jmax(mDepthRamp[mChunkStart], mDepthRamp[chunkSize - 1]);
+
+    // The envelope can push the depth up to as far as its amount, wherever the level goes
+    if(mChunkHasEnvelopeDepth) {
+        depth = juce::jmin(1.0, depth + juce::jmax(std::abs(mEnvelopeDepthRamp[mChunkStart]), std::abs(mEnvelopeDepthRamp[chunkSize - 1])));
+    }
+
+    const double amplitude = mMaxTapSwing * depth;
+    const double curvature = amplitude * w * w;
+
+    if(curvature <= 0) {
+        return mControlInterval;
+    }
+
+    const double longestInterval = std::sqrt(8.0 * controlRateTolerance / curvature);
+
+    return juce::jlimit(1, mControlInterval, (int) juce::jmin(longestInterval, (double) maxControlInterval));
+}
+
+void ChorusKernel::prepareTapRotation()
+{
+    // Rotating the tap phase offsets linearly from the start to the end of the chunk
+    mRotatingOffsets = mPhaseOffset.isSmoothing();
+
+    if(! mRotatingOffsets) {
+        return;
+    }
+
+    const int numSamples = chunkSize - mChunkStart;
+    getTapPhaseOffsets(mPhaseOffset.skip(numSamples), mTapOffsetCosEnd, mTapOffsetSinEnd);
+
+    for(int group = 0; group < mNumTapGroups; group++) {
+        mTapOffsetCosStep[group] = (mTapOffsetCosEnd[group] - mTapOffsetCos[group]) * (1.0f / (float) numSamples);
+        mTapOffsetSinStep[group] = (mTapOffsetSinEnd[group] - mTapOffsetSin[group]) * (1.0f / (float) numSamples);
+    }
+}
+
+void ChorusKernel::getTapDelaysAt(int j, float envelopeLevel, Vec* delays) const
+{
+    // Calculating the delay of every tap at a control point with LFO + offset
+    const float lfoSin = mLFOSin[j];
+    const float lfoCos = mLFOCos[j];
+    const float depth = mChunkHasEnvelopeDepth ? juce::jlimit(0.0f, 1.0f, mDepthRamp[j] + mEnvelopeDepthRamp[j] * envelopeLevel) : mDepthRamp[j];
+
+    for(int group = 0; group < mNumTapGroups; group++) {
+        Vec offsetCos = mTapOffsetCos[group];
+        Vec offsetSin = mTapOffsetSin[group];
+
+        if(mRotatingOffsets) {
+            offsetCos = offsetCos + mTapOffsetCosStep[group] * (float) (j - mChunkStart);
+            offsetSin = offsetSin + mTapOffsetSinStep[group] * (float) (j - mChunkStart);
+        }
+
+        const Vec lfoOut = offsetCos * lfoSin + offsetSin * lfoCos;
+        delays[group] = mTapDelayCentre[group] + lfoOut * (mTapDelaySwing[group] * depth);
+    }
+}
+
+void ChorusKernel::startSegment(int j)
+{
+    // The envelope holds its level up to the next control point
+    const float envelopeLevel = getEnvelopeLevel(j);
+
+    // Landing exactly on the control point so rounding never accumulates,
+    // or starting from the LFO if the ramps were interrupted
+    if(mTapDelaysValid) {
+        for(int group = 0; group < mNumTapGroups; group++) {
+            mTapDelay[group] = mTapDelayTarget[group];
+        }
+    }
+    else {
+        getTapDelaysAt(j, envelopeLevel, mTapDelay);
+        mTapDelaysValid = true;
+    }
+
+    // The control points sit on a grid counted from the start of the chunk, wherever the block started,
+    // and on the start of every envelope segment while the follower runs
+    mNextControlPoint = juce::jmin((j / mChunkControlInterval + 1) * mChunkControlInterval, chunkSize);
+
+    if(mEnvelopeLevels != nullptr) {
+        const int segment = getEnvelopeSegment(j + mChunkBlockOffset);
+        const int nextBoundary = mFirstEnvelopeBoundary + segment * EnvelopeFollower::segmentSize - mChunkBlockOffset;
+
+        mNextControlPoint = juce::jmin(mNextControlPoint, nextBoundary);
+    }
+
+    getTapDelaysAt(mNextControlPoint, envelopeLevel, mTapDelayTarget);
+
+    // Adding the envelope to the mix up to there, unless an interrupted ramp already did
+    if(mChunkHasEnvelopeMix && mNextControlPoint > mEnvelopeMixEnd) {
+        applyEnvelopeMix(juce::jmax(j, mEnvelopeMixEnd), mNextControlPoint);
+        mEnvelopeMixEnd = mNextControlPoint;
+    }
+
+    const float segmentScale = 1.0f / (float) (mNextControlPoint - j);
+
+    for(int group = 0; group < mNumTapGroups; group++) {
+        mTapDelayStep[group] = (mTapDelayTarget[group] - mTapDelay[group]) * segmentScale;
+    }
+}
+
+int ChorusKernel::getEnvelopeSegment(int blockSample) const
+{
+    // Segment 0 was in progress when the block started, the others start at the boundaries in it
+    if(blockSample < mFirstEnvelopeBoundary) {
+        return 0;
+    }
+
+    return (blockSample - mFirstEnvelopeBoundary) / EnvelopeFollower::segmentSize + 1;
+}
+
+float ChorusKernel::getEnvelopeLevel(int j) const
+{
+    // The level at the start of the segment that chunk position j lies in
+    if(mEnvelopeLevels == nullptr) {
+        return mHeldEnvelopeLevel;
+    }
+
+    return mEnvelopeLevels[getEnvelopeSegment(j + mChunkBlockOffset) + 1];
+}
+
+float ChorusKernel::getModulatedRate(int j) const
+{
+    const float rate = mRate.getCurrentValue();
+    const float envelopeRate = mEnvelopeRate.getCurrentValue();
+
+    if(juce::exactlyEqual(envelopeRate, 0.0f)) {
+        return rate;
+    }
+
+    return juce::jlimit(minRate, maxRate, rate * std::exp2(envelopeRate * getEnvelopeLevel(j) * envelopeRateOctaves));
+}
+
+void ChorusKernel::applyEnvelopeMix(int start, int end)
+{
+    // Start and end lie in one envelope segment, over which the level ramps from the previous one
+    float startLevel = mHeldEnvelopeLevel;
+    float endLevel = mHeldEnvelopeLevel;
+    int segmentStart = start + mChunkBlockOffset;
+
+    if(mEnvelopeLevels != nullptr) {
+        const int segment = getEnvelopeSegment(start + mChunkBlockOffset);
+
+        startLevel = mEnvelopeLevels[segment];
+        endLevel = mEnvelopeLevels[segment + 1];
+        segmentStart = mFirstEnvelopeBoundary + (segment - 1) * EnvelopeFollower::segmentSize;
+    }
+
+    const float levelStep = (endLevel - startLevel) * (1.0f / (float) EnvelopeFollower::segmentSize);
+    const int firstStep = start + mChunkBlockOffset - segmentStart;
+    const int last = end - 1;
+
+    // Limiting the mix at both ends and ramping the difference in between, which stays within
+    // the ends while the mix and the amount hold still, so no sample needs a clamp of its own
+    const float firstLevel = startLevel + levelStep * (float) firstStep;
+    const float lastLevel = startLevel + levelStep * (float) (firstStep + last - start);
+    const float firstOffset = juce::jlimit(0.0f, 1.0f, mDryWetRamp[start] + mEnvelopeMixRamp[start] * firstLevel) - mDryWetRamp[start];
+    const float lastOffset = juce::jlimit(0.0f, 1.0f, mDryWetRamp[last] + mEnvelopeMixRamp[last] * lastLevel) - mDryWetRamp[last];
+    const float offsetStep = last > start ? (lastOffset - firstOffset) / (float) (last - start) : 0.0f;
+
+    float* dryWet = mDryWetRamp + start;
+
+    for(int i = 0; i < end - start; i++) {
+        dryWet[i] += firstOffset + offsetStep * (float) i;
+    }
+}
+
+void ChorusKernel::finishTapRotation()
+{
+    if(! mRotatingOffsets) {
+        return;
+    }
+
+    for(int group = 0; group < mNumTapGroups; group++) {
+        mTapOffsetCos[group] = mTapOffsetCosEnd[group];
+        mTapOffsetSin[group] = mTapOffsetSinEnd[group];
+    }
+}
+
+template <typename Interpolator>
+int ChorusKernel::getBlockWindow() const
+{
+    // The newest frame a tap reads lies this far past the integer part of its read head,
+    // and one more frame is kept free for rounding in the ramped delays
+    const int lookahead = Interpolator::firstPoint + Interpolator::numPoints - 1;
+
+    return juce::jmin(maxBlockWindow, (int) mMinTapDelay - lookahead - 1);
+}
+
+template <typename SampleType, typename Interpolator, typename Paths>
+void ChorusKernel::processChunkMono(SampleType* channel, int startSample, int numSamples)
+{
+    const float length = (float) mDelayLine.getLength();
+    const int mask = mDelayLine.getMask();
+    const int stride = mDelayLine.getNumChannels();
+    float* const delayData = mDelayLine.getFrame(0);
+
+    float feedback = mFeedback[0];
+    float interpolatorState = mInterpolatorState[0].get(0);
+    int writeHead = mDelayLineWriteHead;
+
+    float delayTimeSamples = mTapDelay[0].get(0);
+    float delayStep = mTapDelayStep[0].get(0);
+
+    // Working in chunk positions, the ramps and the control points are laid out over the chunk
+    const int chunkEnd = mChunkPosition + numSamples;
+
+    for(int segmentStart = mChunkPosition; segmentStart < chunkEnd; ) {
+        // Ramping the delay towards its value at the next control point
+        if(segmentStart == mNextControlPoint || ! mTapDelaysValid) {
+            startSegment(segmentStart);
+            delayTimeSamples = mTapDelay[0].get(0);
+            delayStep = mTapDelayStep[0].get(0);
+        }
+
+        const int segmentEnd = juce::jmin(mNextControlPoint, chunkEnd);
+
+        for(int j = segmentStart; j < segmentEnd; j++) {
+            const int i = startSample + j - mChunkPosition;
+            const SampleType dry = channel[i];
+
+            // Writing to buffer and adding feedback
+            delayData[writeHead * stride] = Paths::feedback ? (float) dry + feedback : (float) dry;
+
+            // Calculating read head from the ramped delay
+            const float delayReadHead = (length + (float) writeHead) - delayTimeSamples;
+            delayTimeSamples += delayStep;
+
+            const int readHead_x = (int) delayReadHead;
+            const float readHeadFloat = delayReadHead - (float) readHead_x;
+
+            // Interpolating delay sample from current read head position
+            float points[Interpolator::numPoints];
+
+            for(int k = 0; k < Interpolator::numPoints; k++) {
+                points[k] = delayData[((readHead_x + Interpolator::firstPoint + k) & mask) * stride];
+            }
+
+            const float delaySample = Interpolator::interpolate(points, readHeadFloat, interpolatorState);
+
+            // Calculating feedback sample
+            if(Paths::feedback) {
+                feedback = delaySample * mFeedbackRamp[j];
+            }
+
+            // Mixing sample between dry and wet signal, a fully wet mix leaves the dry sample out
+            if(Paths::wet) {
+                const float wetAmount = mDryWetRamp[j];
+                channel[i] = Paths::dry ? dry * (SampleType) (1.0f - wetAmount) + (SampleType) (delaySample * wetAmount)
+                                        : (SampleType) (delaySample * wetAmount);
+            }
+
+            // Updating buffer write head
+            writeHead = (writeHead + 1) & mask;
+        }
+
+        segmentStart = segmentEnd;
+    }
+
+    // Without the feedback path nothing goes back into the line, the same as in processChunkDry
+    mFeedback[0] = Paths::feedback ? feedback : 0.0f;
+    mInterpolatorState[0].set(0, interpolatorState);
+    mTapDelay[0].set(0, delayTimeSamples);
+    mDelayLineWriteHead = writeHead;
+}
+
+template <typename SampleType, typename Interpolator, typename Paths>
+void ChorusKernel::processChunk(SampleType* const* channels, int numChannels, int startSample, int numSamples)
+{
+    // Reading behind writeHead + length keeps the read head positive, so every index wraps with the mask
+    const Vec length = Vec::expand((float) mDelayLine.getLength());
+    const int mask = mDelayLine.getMask();
+    const int stride = mDelayLine.getNumChannels();
+    float* const delayData = mDelayLine.getFrame(0);
+
+    alignas(Vec::SIMDRegisterSize) float readIndices[maxTapGroups * lanes] = {};
+    alignas(Vec::SIMDRegisterSize) float samples[Interpolator::numPoints][maxTapGroups * lanes] = {};
+    alignas(Vec::SIMDRegisterSize) float tapOut[maxTapGroups * lanes] = {};
+
+    Vec readHeadFloat[maxTapGroups];
+
+    // Working in chunk positions, the ramps and the control points are laid out over the chunk
+    const int chunkEnd = mChunkPosition + numSamples;
+
+    for(int segmentStart = mChunkPosition; segmentStart < chunkEnd; ) {
+        // Ramping every tap's delay towards its value at the next control point
+        if(segmentStart == mNextControlPoint || ! mTapDelaysValid) {
+            startSegment(segmentStart);
+        }
+
+        const int segmentEnd = juce::jmin(mNextControlPoint, chunkEnd);
+
+        for(int j = segmentStart; j < segmentEnd; j++) {
+            const int i = startSample + j - mChunkPosition;
+
+            // Writing to buffer and adding feedback
+            float* const writeFrame = delayData + mDelayLineWriteHead * stride;
+
+            for(int channel = 0; channel < numChannels; channel++) {
+                writeFrame[channel] = Paths::feedback ? (float) channels[channel][i] + mFeedback[channel] : (float) channels[channel][i];
+            }
+
+            // Calculating read heads for all taps from the ramped delays
+            const Vec writeHead = length + (float) mDelayLineWriteHead;
+
+            for(int group = 0; group < mNumTapGroups; group++) {
+                const Vec delayReadHead = writeHead - mTapDelay[group];
+                const Vec readHeadX = Vec::truncate(delayReadHead);
+
+                mTapDelay[group] = mTapDelay[group] + mTapDelayStep[group];
+
+                readHeadFloat[group] = delayReadHead - readHeadX;
+                readHeadX.copyToRawArray(readIndices + group * lanes);
+            }
+
+            // Gathering the interpolator's samples around the read head for every tap
+            for(int tap = 0; tap < mNumTaps; tap++) {
+                const int readHead_x = (int) readIndices[tap] + Interpolator::firstPoint;
+                const int channel = mTapChannel[tap];
+
+                for(int k = 0; k < Interpolator::numPoints; k++) {
+                    samples[k][tap] = delayData[((readHead_x + k) & mask) * stride + channel];
+                }
+            }
+
+            // Interpolating delay samples from current read head positions
+            for(int group = 0; group < mNumTapGroups; group++) {
+                Vec points[Interpolator::numPoints];
+
+                for(int k = 0; k < Interpolator::numPoints; k++) {
+                    points[k] = Vec::fromRawArray(samples[k] + group * lanes);
+                }
+
+                const Vec delaySamples = Interpolator::interpolate(points, readHeadFloat[group], mInterpolatorState[group]);
+                (delaySamples * mTapGain[group]).copyToRawArray(tapOut + group * lanes);
+            }
+
+            const float feedbackAmount = mFeedbackRamp[j];
+            const float wetAmount = mDryWetRamp[j];
+
+            for(int channel = 0; channel < numChannels; channel++) {
+                // Summing the voices of this channel
+                const float* channelTaps = tapOut + channel * mNumVoices;
+                float delaySample = 0;
+
+                for(int voice = 0; voice < mNumVoices; voice++) {
+                    delaySample += channelTaps[voice];
+                }
+
+                // Calculating feedback samples
+                if(Paths::feedback) {
+                    mFeedback[channel] = delaySample * feedbackAmount;
+                }
+
+                // Mixing sample between dry and wet signal, a fully wet mix leaves the dry sample out
+                if(Paths::wet) {
+                    channels[channel][i] = Paths::dry ? channels[channel][i] * (SampleType) (1.0f - wetAmount) + (SampleType) (delaySample * wetAmount)
+                                                      : (SampleType) (delaySample * wetAmount);
+                }
+            }
+
+            // Updating buffer write head
+            mDelayLineWriteHead = (mDelayLineWriteHead + 1) & mask;
+        }
+
+        segmentStart = segmentEnd;
+    }
+
+    // Without the feedback path nothing goes back into the line, the same as in processChunkDry
+    if(! Paths::feedback) {
+        for(int channel = 0; channel < numChannels; channel++) {
+            mFeedback[channel] = 0;
+        }
+    }
+}
+
+template <typename SampleType, typename Interpolator, typename Paths>
+void ChorusKernel::processChunkBlock(SampleType* const* channels, int numChannels, int startSample, int numSamples, int windowSize)
+{
+    const float length = (float) mDelayLine.getLength();
+    const int mask = mDelayLine.getMask();
+    const int stride = mDelayLine.getNumChannels();
+    float* const delayData = mDelayLine.getFrame(0);
+
+    // Lanes past the end of a window are computed from stale values and never used
+    alignas(Vec::SIMDRegisterSize) float samples[Interpolator::numPoints][maxBlockWindow] = {};
+    alignas(Vec::SIMDRegisterSize) float readHeadFloat[maxBlockWindow] = {};
+    alignas(Vec::SIMDRegisterSize) float tapOut[maxBlockWindow] = {};
+    alignas(Vec::SIMDRegisterSize) float feedback[maxBlockWindow] = {};
+
+    for(int windowStart = 0; windowStart < numSamples; windowStart += windowSize) {
+        const int windowLength = juce::jmin(windowSize, numSamples - windowStart);
+        const int paddedLength = (windowLength + lanes - 1) / lanes * lanes;
+
+        // Working in chunk positions, the ramps and the control points are laid out over the chunk
+        const int chunkStart = mChunkPosition + windowStart;
+
+        // Ramping every tap's delay through the window the same way the per-sample loop does
+        for(int j = 0; j < windowLength; j++) {
+            if(chunkStart + j == mNextControlPoint || ! mTapDelaysValid) {
+                startSegment(chunkStart + j);
+            }
+
+            for(int group = 0; group < mNumTapGroups; group++) {
+                mWindowDelay[j][group] = mTapDelay[group];
+                mTapDelay[group] = mTapDelay[group] + mTapDelayStep[group];
+            }
+        }
+
+        for(int channel = 0; channel < numChannels; channel++) {
+            juce::FloatVectorOperations::clear(mWindowWet[channel], windowLength);
+        }
+
+        // No tap reads a frame written inside the window, so each one is interpolated for all of it at once
+        for(int tap = 0; tap < mNumTaps; tap++) {
+            const int group = tap / lanes;
+            const size_t lane = (size_t) (tap % lanes);
+            const int channel = mTapChannel[tap];
+
+            for(int j = 0; j < windowLength; j++) {
+                const float writeHead = length + (float) ((mDelayLineWriteHead + j) & mask);
+                const float delayReadHead = writeHead - mWindowDelay[j][group].get(lane);
+                const int readHead_x = (int) delayReadHead;
+
+                readHeadFloat[j] = delayReadHead - (float) readHead_x;
+
+                for(int k = 0; k < Interpolator::numPoints; k++) {
+                    samples[k][j] = delayData[((readHead_x + Interpolator::firstPoint + k) & mask) * stride + channel];
+                }
+            }
+
+            const Vec gain = Vec::expand(mTapGain[group].get(lane));
+
+            for(int j = 0; j < paddedLength; j += lanes) {
+                Vec points[Interpolator::numPoints];
+
+                for(int k = 0; k < Interpolator::numPoints; k++) {
+                    points[k] = Vec::fromRawArray(samples[k] + j);
+                }
+
+                // None of the interpolators run here keep any state
+                Vec state = Vec::expand(0.0f);
+                const Vec delaySamples = Interpolator::interpolate(points, Vec::fromRawArray(readHeadFloat + j), state);
+                (delaySamples * gain).copyToRawArray(tapOut + j);
+            }
+
+            // Summing the voices of this channel
+            juce::FloatVectorOperations::add(mWindowWet[channel], tapOut, windowLength);
+        }
+
+        for(int channel = 0; channel < numChannels; channel++) {
+            SampleType* const channelSamples = channels[channel] + startSample + windowStart;
+            const float* const wet = mWindowWet[channel];
+
+            // Calculating feedback samples, each one goes into the line with the next input sample
+            if(Paths::feedback) {
+                juce::FloatVectorOperations::multiply(feedback, wet, mFeedbackRamp + chunkStart, windowLength);
+            }
+
+            float previousFeedback = mFeedback[channel];
+
+            for(int j = 0; j < windowLength; j++) {
+                const SampleType dry = channelSamples[j];
+
+                // Writing to buffer and adding feedback
+                if(Paths::feedback) {
+                    delayData[((mDelayLineWriteHead + j) & mask) * stride + channel] = (float) dry + previousFeedback;
+                    previousFeedback = feedback[j];
+                }
+                else {
+                    delayData[((mDelayLineWriteHead + j) & mask) * stride + channel] = (float) dry;
+                }
+
+                // Mixing sample between dry and wet signal, a fully wet mix leaves the dry sample out
+                if(Paths::wet) {
+                    const float wetAmount = mDryWetRamp[chunkStart + j];
+                    channelSamples[j] = Paths::dry ? dry * (SampleType) (1.0f - wetAmount) + (SampleType) (wet[j] * wetAmount)
+                                                   : (SampleType) (wet[j] * wetAmount);
+                }
+            }
+
+            // Without the feedback path nothing goes back into the line, the same as in processChunkDry
+            mFeedback[channel] = Paths::feedback ? previousFeedback : 0.0f;
+        }
+
+        // Updating buffer write head
+        mDelayLineWriteHead = (mDelayLineWriteHead + windowLength) & mask;
+    }
+}
+
+//==============================================================================
+template void ChorusKernel::process<float>(float* const*, int, int, const Parameters&, const float*, int);
+template void ChorusKernel::process<double>(double* const*, int, int, const Parameters&, const float*, int);
@@ -0,0 +1,342 @@
+/*
+  ==============================================================================
+
+    ChorusKernel.h
+
+    Runs the modulated delay for every voice of every channel at once. Each
+    (channel, voice) pair is a tap into the shared delay line, and the taps
+    are laid out as structure-of-arrays so juce::dsp::SIMDRegister lanes
+    evaluate several of them in one pass. Any channel count up to maxChannels
+    works, and a single voice on a mono bus takes a scalar fast path. The
+    inner loops are instantiated once per fractional delay interpolator.
+
+    Once the input has gone silent and the feedback tail has decayed below
+    silenceThreshold, the kernel goes idle and only keeps its modulation state
+    moving until the input comes back.
+
+    The delay times are computed at control rate, every few samples, and the
+    audio rate loop only ramps the read heads linearly between them. The
+    control interval is shortened whenever the LFO is fast or deep enough that
+    the ramps would stray more than controlRateTolerance samples from it.
+
+    The audio is worked through in chunks of chunkSize samples counted from
+    the last reset, not from the start of each block. The LFO and the
+    parameter ramps are rendered for a whole chunk when it starts, the control
+    points sit on a grid within it, and a ramp that is cut off by the end of
+    a block carries on with the next one. So the output doesn't depend on how
+    the host splits the audio into blocks, and a new snapshot is picked up
+    when the next chunk starts. That is up to chunkSize samples after the
+    block that carries it, about 5 ms at 48 kHz.
+
+    The envelope follower's segments start control points of their own. Over
+    each segment the delays follow the depth the level at its start gives, and
+    the mix ramps from the level at the start of the previous segment to that
+    one, while the rate is moved once per chunk.
+
+    Each chunk runs a loop compiled for the signal paths it needs. A mix held
+    at fully dry or fully wet, or feedback held at zero, drops the work for that
+    path; a fully dry chunk without feedback only writes its input to the delay
+    line. Vibrato always runs fully wet without feedback and the doubler without
+    feedback, so both always take one of those loops.
+
+    The block engine steps through time in windows shorter than the shortest
+    delay any tap can read. Nothing read inside a window was written inside it,
+    so every tap is interpolated for the whole window at once, with consecutive
+    samples in the SIMD lanes, and the window is written back to the delay line
+    with its feedback afterwards. It produces the same output as the per-sample
+    engine; interpolators that keep state between samples always run per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayLine.h"
+#include "EnvelopeFollower.h"
+#include "Interpolators.h"
+#include "LFOEngine.h"
+
+//==============================================================================
+/** Matches the order of the processor's type parameter. */
+enum class EffectType
+{
+    chorus = 0,
+    flanger,
+    vibrato,
+    doubler
+};
+
+static constexpr int numEffectTypes = 4;
+
+inline juce::StringArray getEffectTypeNames()
+{
+    return { "Chorus", "Flanger", "Vibrato", "Doubler" };
+}
+
+//==============================================================================
+/**
+*/
+class ChorusKernel
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+    static constexpr int maxChannels = 16;
+    static constexpr int maxVoices = 8;
+    static constexpr int maxTaps = maxChannels * maxVoices;
+    static constexpr int maxTapGroups = (maxTaps + lanes - 1) / lanes;
+
+    static constexpr int chunkSize = 256;
+    static constexpr double smoothingTimeSeconds = 0.02;
+
+    /** The range of the LFO rate, in Hz. */
+    static constexpr float minRate = 0.1f;
+    static constexpr float maxRate = 20.0f;
+
+    /** A full envelope moves the rate by this many octaves at an amount of 1. */
+    static constexpr float envelopeRateOctaves = 3.0f;
+
+    /** Voices are spread over this range around each mode's delay times. */
+    static constexpr float minVoiceDelayScale = 0.8f;
+    static constexpr float maxVoiceDelayScale = 1.2f;
+
+    /** The longest delay any mode reads, the delay line is sized from this. */
+    static constexpr float maxDelaySeconds = 0.03f * maxVoiceDelayScale;
+
+    /** Roughly -96 dB, anything below this counts as silence. */
+    static constexpr float silenceThreshold = 1.585e-5f;
+
+    /** Delay times are recomputed at most every maxControlInterval samples. */
+    static constexpr int maxControlInterval = 64;
+    static constexpr int defaultControlInterval = 32;
+
+    /** How far, in samples, the ramped delay times may stray from the LFO. */
+    static constexpr double controlRateTolerance = 0.01;
+
+    /** The longest window the block engine processes at once. */
+    static constexpr int maxBlockWindow = 32;
+
+    /** How the feedback loop is stepped through time. */
+    enum class Engine
+    {
+        perSample = 0,
+        block
+    };
+
+    /** Snapshot of the processor's parameters, taken once per block. */
+    struct Parameters
+    {
+        float dryWet;
+        float depth;
+        float rate;
+        float phaseOffset;
+        float feedback;
+        int type;
+        int voices;
+        int interpolation;
+
+        // How far the input level moves depth, rate and mix, from -1 to 1
+        float envelopeDepth = 0;
+        float envelopeRate = 0;
+        float envelopeMix = 0;
+    };
+
+    ChorusKernel();
+
+    void prepare(double sampleRate, int numChannels);
+    void reset();
+
+    /** Instantiated for float and double buffers. The delay line and the modulation
+        always run in float, the dry signal passes through at the buffer's precision.
+        envelopeLevels are the follower's levels for this block, as EnvelopeFollower::process
+        hands them out, and without them the envelope stays where it was last. */
+    template <typename SampleType>
+    void process(SampleType* const* channels, int numChannels, int numSamples, const Parameters& parameters,
+                 const float* envelopeLevels = nullptr, int firstEnvelopeBoundary = 0);
+
+    bool isIdle() const { return mIdle; }
+
+    /** The LFO's value on the last sample processed and the first tap's current delay, for display. */
+    float getLFOValue() const { return mLFOValue; }
+    float getDelayTimeSamples() const { return mTapDelay[0].get(0); }
+
+    /** The longest control interval to use, 1 recomputes the delays every sample. */
+    void setControlInterval(int numSamples);
+    int getControlInterval() const { return mControlInterval; }
+
+    void setEngine(Engine engine) { mEngine = engine; }
+    Engine getEngine() const { return mEngine; }
+
+    /** How long the feedback loop keeps ringing above silenceThreshold with these parameters. */
+    static double getTailLengthSeconds(const Parameters& parameters);
+
+    /** The parameters with whatever the effect type fixes applied: vibrato is fully wet
+        whatever the envelope does, vibrato and the doubler never feed back. Apply before
+        any crossfade, so fades between types still ramp the mix. */
+    static Parameters applyEffectType(Parameters parameters);
+
+private:
+    /** Which parts of the signal flow a chunk needs, the inner loops are compiled once for each. */
+    template <bool Dry, bool Wet, bool Feedback>
+    struct SignalPaths
+    {
+        static constexpr bool dry = Dry;
+        static constexpr bool wet = Wet;
+        static constexpr bool feedback = Feedback;
+    };
+
+    void setInterpolation(InterpolationType interpolation);
+
+    template <typename SampleType>
+    void processWithInterpolator(SampleType* const* channels, int numChannels, int startSample, int endSample);
+    template <typename SampleType, typename Interpolator>
+    void processChunks(SampleType* const* channels, int numChannels, int startSample, int endSample);
+    template <typename SampleType, typename Interpolator, typename Paths>
+    void processChunkPaths(SampleType* const* channels, int numChannels, int startSample, int numSamples, int windowSize, bool block);
+    template <typename SampleType, typename Interpolator, typename Paths>
+    void processChunk(SampleType* const* channels, int numChannels, int startSample, int numSamples);
+    template <typename SampleType, typename Interpolator, typename Paths>
+    void processChunkMono(SampleType* channel, int startSample, int numSamples);
+    template <typename SampleType, typename Interpolator, typename Paths>
+    void processChunkBlock(SampleType* const* channels, int numChannels, int startSample, int numSamples, int windowSize);
+    template <typename SampleType>
+    void processChunkDry(SampleType* const* channels, int numChannels, int startSample, int numSamples);
+
+    void prepareChunk();
+    int getChunkControlInterval(float rate) const;
+
+    template <typename Interpolator>
+    int getBlockWindow() const;
+
+    void prepareTapRotation();
+    void getTapDelaysAt(int j, float envelopeLevel, Vec* delays) const;
+    void startSegment(int j);
+    void finishTapRotation();
+
+    int getEnvelopeSegment(int blockSample) const;
+    float getEnvelopeLevel(int j) const;
+    float getModulatedRate(int j) const;
+    void applyEnvelopeMix(int start, int end);
+
+    template <typename SampleType>
+    void processIdle(SampleType* const* channels, int numChannels, int numSamples);
+    void updateSilence(int numSamples);
+
+    template <typename SampleType>
+    static bool isSilent(SampleType* const* channels, int numChannels, int numSamples);
+    static void getDelayRange(int type, float& minDelay, float& maxDelay);
+
+    void updateTaps(int numChannels, int numVoices, int type);
+    void getTapPhaseOffsets(float phaseOffset, Vec* offsetCos, Vec* offsetSin) const;
+
+    static void fillRamp(juce::SmoothedValue<float>& value, float* ramp, int numSamples);
+
+    double mSampleRate;
+
+    LFOEngine mLFO;
+    // One extra value for the control point on the first sample of the next chunk
+    float mLFOSin[chunkSize + 1];
+    float mLFOCos[chunkSize + 1];
+    float mLFOValue;
+
+    // Where in the current chunk processing stands, and from where its values were rendered
+    int mChunkPosition;
+    int mChunkStart;
+    bool mChunkPrepared;
+
+    // The signal paths the current chunk needs, picked when its ramps are rendered
+    bool mChunkHasDry;
+    bool mChunkHasWet;
+    bool mChunkHasFeedback;
+
+    // Parameters ramp linearly towards each block's snapshot
+    juce::SmoothedValue<float> mDryWet;
+    juce::SmoothedValue<float> mDepth;
+    juce::SmoothedValue<float> mRate;
+    juce::SmoothedValue<float> mPhaseOffset;
+    juce::SmoothedValue<float> mFeedbackAmount;
+    bool mSnapParameters;
+
+    float mDryWetRamp[chunkSize];
+    float mDepthRamp[chunkSize + 1];
+    float mFeedbackRamp[chunkSize];
+
+    // The envelope amounts ramp the same way, and the chunk only follows the level where they aren't zero
+    juce::SmoothedValue<float> mEnvelopeDepth;
+    juce::SmoothedValue<float> mEnvelopeRate;
+    juce::SmoothedValue<float> mEnvelopeMix;
+    bool mChunkHasEnvelopeDepth;
+    bool mChunkHasEnvelopeMix;
+
+    float mEnvelopeDepthRamp[chunkSize + 1];
+    float mEnvelopeMixRamp[chunkSize];
+
+    // The follower's levels for the block being processed, and where the chunk sits in that block
+    const float* mEnvelopeLevels;
+    int mFirstEnvelopeBoundary;
+    float mHeldEnvelopeLevel;
+    int mChunkBlockOffset;
+
+    // How far into the chunk the mix ramp already has the envelope added
+    int mEnvelopeMixEnd;
+
+    // Tap layout, tap t belongs to channel t / mNumVoices
+    int mNumChannels;
+    int mNumVoices;
+    int mType;
+    int mNumTaps;
+    int mNumTapGroups;
+
+    int mTapChannel[maxTaps];
+    float mTapPhase[maxTaps];
+
+    // Per tap state, one register per group of taps
+    Vec mTapOffsetCos[maxTapGroups];
+    Vec mTapOffsetSin[maxTapGroups];
+    Vec mTapDelayCentre[maxTapGroups];
+    Vec mTapDelaySwing[maxTapGroups];
+    Vec mTapGain[maxTapGroups];
+    float mMaxTapSwing;
+    float mMinTapDelay;
+
+    // Where the tap phase offsets rotate to over the current chunk
+    Vec mTapOffsetCosEnd[maxTapGroups];
+    Vec mTapOffsetSinEnd[maxTapGroups];
+    Vec mTapOffsetCosStep[maxTapGroups];
+    Vec mTapOffsetSinStep[maxTapGroups];
+    bool mRotatingOffsets;
+
+    // Delay time of every tap at the current sample, ramped towards the next control point
+    Vec mTapDelay[maxTapGroups];
+    Vec mTapDelayTarget[maxTapGroups];
+    Vec mTapDelayStep[maxTapGroups];
+    int mNextControlPoint;
+    bool mTapDelaysValid;
+
+    int mControlInterval;
+    int mChunkControlInterval;
+
+    Engine mEngine;
+
+    // Delay of every tap at each sample of the block engine's window, and each channel's wet sum
+    Vec mWindowDelay[maxBlockWindow][maxTapGroups];
+    float mWindowWet[maxChannels][maxBlockWindow];
+
+    // Interpolator memory per tap, only the allpass keeps any
+    InterpolationType mInterpolation;
+    Vec mInterpolatorState[maxTapGroups];
+
+    float mFeedback[maxChannels];
+
+    DelayLine mDelayLine;
+    int mDelayLineWriteHead;
+
+    // Samples written to the delay line in a row that were all below the silence threshold
+    int mQuietSamples;
+    bool mIdle;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusKernel)
+};
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    DelayLine.cpp
+
+  ==============================================================================
+*/
+
+#include "DelayLine.h"
+
+//==============================================================================
+DelayLine::DelayLine()
+{
+    mData = nullptr;
+    mAllocatedSize = 0;
+
+    mNumChannels = 0;
+    mLength = 0;
+    mMask = 0;
+}
+
+DelayLine::~DelayLine()
+{
+    mPool->release(mData, mAllocatedSize);
+}
+
+void DelayLine::prepare(int numChannels, int minimumLength)
+{
+    mNumChannels = juce::jmax(1, numChannels);
+    mLength = juce::nextPowerOfTwo(juce::jmax(2, minimumLength));
+    mMask = mLength - 1;
+
+    const size_t size = (size_t) mLength * (size_t) mNumChannels;
+
+    // Only going back to the pool when the layout or sample rate needs more room than we have,
+    // the old block is handed back so the next instance at this size can reuse it
+    if(size > mAllocatedSize) {
+        mPool->release(mData, mAllocatedSize);
+        mData = mPool->allocate(size, mAllocatedSize);
+    }
+
+    clear();
+}
+
+void DelayLine::clear()
+{
+    if(mData != nullptr) {
+        juce::zeromem(mData, getSizeInBytes());
+    }
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    DelayLine.h
+
+    Interleaved multi-channel ring buffer with a power-of-two length, so the
+    read and write heads wrap with a bitmask instead of a branch.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DelayLinePool.h"
+
+//==============================================================================
+/**
+    Samples are stored frame by frame, [frame][channel], so both taps of a
+    fractional read for all channels sit next to each other in memory. The
+    storage comes from the process-wide DelayLinePool.
+*/
+class DelayLine
+{
+public:
+    DelayLine();
+    ~DelayLine();
+
+    /** Makes room for at least minimumLength frames, rounded up to a power of two.
+        Grows the storage if the channel count or sample rate needs more than
+        the last call did. */
+    void prepare(int numChannels, int minimumLength);
+    void clear();
+
+    int getNumChannels() const { return mNumChannels; }
+    int getLength() const { return mLength; }
+    int getMask() const { return mMask; }
+    size_t getSizeInBytes() const { return (size_t) mLength * (size_t) mNumChannels * sizeof(float); }
+
+    float* getFrame(int index) { return mData + (size_t) ((index & mMask) * mNumChannels); }
+    const float* getFrame(int index) const { return mData + (size_t) ((index & mMask) * mNumChannels); }
+
+private:
+    juce::SharedResourcePointer<DelayLinePool> mPool;
+
+    float* mData;
+    size_t mAllocatedSize;
+
+    int mNumChannels;
+    int mLength;
+    int mMask;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayLine)
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    DelayLinePool.cpp
+
+  ==============================================================================
+*/
+
+#include "DelayLinePool.h"
+
+//==============================================================================
+DelayLinePool::DelayLinePool()
+{
+    mTotalSamples = 0;
+    mSamplesInUse = 0;
+}
+
+DelayLinePool::~DelayLinePool()
+{
+    // Every delay line holds a SharedResourcePointer, so nothing can still be using the arenas
+    jassert(mSamplesInUse == 0);
+}
+
+float* DelayLinePool::allocate(size_t numSamples, size_t& allocatedSamples)
+{
+    // Rounding to a power-of-two size class so released blocks are easy to reuse
+    size_t size = 16;
+
+    while(size < numSamples) {
+        size <<= 1;
+    }
+
+    allocatedSamples = size;
+
+    const juce::ScopedLock lock(mLock);
+
+    mSamplesInUse += size;
+
+    auto& freeList = mFreeLists[size];
+
+    if(! freeList.empty()) {
+        float* data = freeList.back();
+        freeList.pop_back();
+        return data;
+    }
+
+    for(auto& arena : mArenas) {
+        if(arena->size - arena->used >= size) {
+            float* data = arena->data.get() + arena->used;
+            arena->used += size;
+            return data;
+        }
+    }
+
+    // Out of room, blocks bigger than an arena get an arena of their own
+    auto arena = std::make_unique<Arena>();
+    arena->size = juce::jmax(arenaSizeInSamples, size);
+    arena->used = size;
+    arena->data.allocate(arena->size, false);
+
+    mTotalSamples += arena->size;
+
+    float* data = arena->data.get();
+    mArenas.push_back(std::move(arena));
+    return data;
+}
+
+void DelayLinePool::release(float* data, size_t allocatedSamples)
+{
+    if(data == nullptr) {
+        return;
+    }
+
+    const juce::ScopedLock lock(mLock);
+
+    jassert(mSamplesInUse >= allocatedSamples);
+    mSamplesInUse -= allocatedSamples;
+
+    mFreeLists[allocatedSamples].push_back(data);
+}
+
+size_t DelayLinePool::getTotalPooledBytes() const
+{
+    const juce::ScopedLock lock(mLock);
+    return mTotalSamples * sizeof(float);
+}
+
+size_t DelayLinePool::getBytesInUse() const
+{
+    const juce::ScopedLock lock(mLock);
+    return mSamplesInUse * sizeof(float);
+}
+
+int DelayLinePool::getNumArenas() const
+{
+    const juce::ScopedLock lock(mLock);
+    return (int) mArenas.size();
+}
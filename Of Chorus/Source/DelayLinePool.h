@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    DelayLinePool.h
+
+    Process-wide arena that every DelayLine draws its storage from, so a
+    session with hundreds of instances makes a few large allocations instead
+    of one or two per instance.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <map>
+
+//==============================================================================
+/**
+    Shared by all processors in the host through juce::SharedResourcePointer,
+    the pool lives as long as at least one instance does.
+
+    Blocks are handed out in power-of-two size classes carved from 4 MB arenas.
+    Released blocks go onto a free list for their size class and are reused by
+    the next request of that size, e.g. when another instance switches to the
+    same sample rate. Allocation takes a lock and must not happen on the audio
+    thread.
+*/
+class DelayLinePool
+{
+public:
+    DelayLinePool();
+    ~DelayLinePool();
+
+    /** Returns storage for at least numSamples floats, not cleared. */
+    float* allocate(size_t numSamples, size_t& allocatedSamples);
+    void release(float* data, size_t allocatedSamples);
+
+    /** Bytes reserved by all arenas, whether handed out or not. */
+    size_t getTotalPooledBytes() const;
+    /** Bytes currently handed out to delay lines. */
+    size_t getBytesInUse() const;
+    int getNumArenas() const;
+
+    static constexpr size_t arenaSizeInSamples = (4 << 20) / sizeof(float);
+
+private:
+    struct Arena
+    {
+        juce::HeapBlock<float> data;
+        size_t size;
+        size_t used;
+    };
+
+    juce::CriticalSection mLock;
+
+    std::vector<std::unique_ptr<Arena>> mArenas;
+    std::map<size_t, std::vector<float*>> mFreeLists;
+
+    size_t mTotalSamples;
+    size_t mSamplesInUse;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayLinePool)
+};
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    EnvelopeFollower.cpp
+
+  ==============================================================================
+*/
+
+#include "EnvelopeFollower.h"
+
+//==============================================================================
+EnvelopeFollower::EnvelopeFollower()
+{
+    mSampleRate = 44100.0;
+    mAttackMs = 10.0f;
+    mReleaseMs = 200.0f;
+    mDetector = EnvelopeDetector::rms;
+
+    mAttackCoefficient = getCoefficient(mAttackMs);
+    mReleaseCoefficient = getCoefficient(mReleaseMs);
+
+    reset();
+}
+
+void EnvelopeFollower::prepare(double sampleRate)
+{
+    mSampleRate = sampleRate;
+
+    // The coefficients are per segment, so they change with the sample rate
+    mAttackCoefficient = getCoefficient(mAttackMs);
+    mReleaseCoefficient = getCoefficient(mReleaseMs);
+
+    reset();
+}
+
+void EnvelopeFollower::reset()
+{
+    mEnvelope = 0;
+    mPreviousEnvelope = 0;
+
+    for(int channel = 0; channel < maxChannels; channel++) {
+        juce::FloatVectorOperations::clear(mSegment[channel], segmentSize);
+    }
+
+    mSegmentSamples = 0;
+}
+
+void EnvelopeFollower::setAttackRelease(float attackMs, float releaseMs)
+{
+    if(! juce::exactlyEqual(attackMs, mAttackMs)) {
+        mAttackMs = attackMs;
+        mAttackCoefficient = getCoefficient(mAttackMs);
+    }
+
+    if(! juce::exactlyEqual(releaseMs, mReleaseMs)) {
+        mReleaseMs = releaseMs;
+        mReleaseCoefficient = getCoefficient(mReleaseMs);
+    }
+}
+
+void EnvelopeFollower::setDetector(EnvelopeDetector detector)
+{
+    mDetector = detector;
+}
+
+float EnvelopeFollower::getCoefficient(float timeMs) const
+{
+    // One pole that covers 1 - 1/e of a step within timeMs, stepped once per segment
+    const double segments = juce::jmax(1.0e-3, timeMs * 0.001 * mSampleRate / segmentSize);
+    return (float) std::exp(-1.0 / segments);
+}
+
+template <typename SampleType>
+int EnvelopeFollower::process(const SampleType* const* channels, int numChannels, int numSamples, float* levels)
+{
+    const int firstBoundary = segmentSize - mSegmentSamples;
+    int numLevels = 0;
+
+    levels[numLevels++] = juce::jmin(1.0f, mPreviousEnvelope);
+    levels[numLevels++] = juce::jmin(1.0f, mEnvelope);
+
+    numChannels = juce::jmin(numChannels, maxChannels);
+
+    if(numChannels <= 0) {
+        return firstBoundary;
+    }
+
+    for(int start = 0; start < numSamples; ) {
+        const int length = juce::jmin(segmentSize - mSegmentSamples, numSamples - start);
+
+        // Collecting what is left of the current segment on every channel
+        for(int channel = 0; channel < numChannels; channel++) {
+            const SampleType* samples = channels[channel] + start;
+            float* segment = mSegment[channel] + mSegmentSamples;
+
+            for(int i = 0; i < length; i++) {
+                segment[i] = (float) samples[i];
+            }
+        }
+
+        start += length;
+        mSegmentSamples += length;
+
+        if(mSegmentSamples < segmentSize) {
+            break;
+        }
+
+        // Stepping the ballistics towards the level of the finished segment
+        const float level = getSegmentLevel(numChannels);
+        const float coefficient = level > mEnvelope ? mAttackCoefficient : mReleaseCoefficient;
+
+        mPreviousEnvelope = mEnvelope;
+        mEnvelope = level + coefficient * (mEnvelope - level);
+        levels[numLevels++] = juce::jmin(1.0f, mEnvelope);
+
+        mSegmentSamples = 0;
+    }
+
+    return firstBoundary;
+}
+
+float EnvelopeFollower::getSegmentLevel(int numChannels) const
+{
+    if(mDetector == EnvelopeDetector::peak) {
+        float peak = 0;
+
+        for(int channel = 0; channel < numChannels; channel++) {
+            const auto range = juce::FloatVectorOperations::findMinAndMax(mSegment[channel], segmentSize);
+            peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+        }
+
+        return peak;
+    }
+
+    double squares = 0;
+
+    for(int channel = 0; channel < numChannels; channel++) {
+        squares += (double) getSumOfSquares(mSegment[channel]) / numChannels;
+    }
+
+    return (float) std::sqrt(squares / segmentSize);
+}
+
+float EnvelopeFollower::getSumOfSquares(const float* samples)
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+    constexpr int lanes = (int) Vec::SIMDNumElements;
+
+    // The segment is aligned and a whole number of registers long
+    Vec sums = Vec::expand(0.0f);
+
+    for(int i = 0; i < segmentSize; i += lanes) {
+        const Vec values = Vec::fromRawArray(samples + i);
+        sums = Vec::multiplyAdd(sums, values, values);
+    }
+
+    return sums.sum();
+}
+
+template int EnvelopeFollower::process<float>(const float* const*, int, int, float*);
+template int EnvelopeFollower::process<double>(const double* const*, int, int, float*);
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    EnvelopeFollower.h
+
+    Follows the level of the input so it can modulate the chorus. The level is
+    detected in short segments with SIMD, and the attack and release ballistics
+    run once per segment instead of once per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Matches the order of the processor's envelope detector parameter. */
+enum class EnvelopeDetector
+{
+    rms = 0,
+    peak
+};
+
+static constexpr int numEnvelopeDetectors = 2;
+
+inline juce::StringArray getEnvelopeDetectorNames()
+{
+    return { "RMS", "Peak" };
+}
+
+//==============================================================================
+/**
+    Measures the RMS or peak level of all channels together over segments of
+    segmentSize samples and smooths it with separate attack and release times.
+    Segments carry over from one block to the next and the envelope is handed
+    out at every segment boundary, so the modulation can follow it at the same
+    samples however the host splits the audio into blocks.
+*/
+class EnvelopeFollower
+{
+public:
+    EnvelopeFollower();
+
+    void prepare(double sampleRate);
+    void reset();
+
+    void setAttackRelease(float attackMs, float releaseMs);
+    void setDetector(EnvelopeDetector detector);
+
+    /** Follows numSamples of every channel. levels gets the envelope before and at the start
+        of the segment in progress, then the envelope at the start of every segment after it,
+        numSamples / segmentSize + 3 values at most, each limited to 1. Returns how far into
+        the block the first of those later segments starts. */
+    template <typename SampleType>
+    int process(const SampleType* const* channels, int numChannels, int numSamples, float* levels);
+
+    float getEnvelope() const { return mEnvelope; }
+
+    static constexpr int segmentSize = 32;
+    static constexpr int maxChannels = 16;
+
+private:
+    float getSegmentLevel(int numChannels) const;
+    static float getSumOfSquares(const float* samples);
+
+    float getCoefficient(float timeMs) const;
+
+    double mSampleRate;
+    float mAttackMs;
+    float mReleaseMs;
+    EnvelopeDetector mDetector;
+
+    float mAttackCoefficient;
+    float mReleaseCoefficient;
+    float mEnvelope;
+    float mPreviousEnvelope;
+
+    // The segment so far, it may have started in the previous block. It is only measured once
+    // it is complete, so the level comes out the same wherever the blocks split it
+    alignas(juce::dsp::SIMDRegister<float>::SIMDRegisterSize) float mSegment[maxChannels][segmentSize];
+    int mSegmentSamples;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeFollower)
+};
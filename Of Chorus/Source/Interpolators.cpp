@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    Interpolators.cpp
+
+  ==============================================================================
+*/
+
+#include "Interpolators.h"
+
+//==============================================================================
+namespace
+{
+    // Blackman windowed sinc weight of a point at the given distance from the read head
+    double getWindowedSinc(double distance)
+    {
+        const double halfLength = SincInterpolator::numPoints / 2;
+
+        if(std::abs(distance) >= halfLength) {
+            return 0.0;
+        }
+
+        const double x = juce::MathConstants<double>::pi * distance;
+        const double sinc = juce::exactlyEqual(distance, 0.0) ? 1.0 : std::sin(x) / x;
+        const double window = 0.42 + 0.5 * std::cos(x / halfLength) + 0.08 * std::cos(2.0 * x / halfLength);
+
+        return sinc * window;
+    }
+
+    // Least squares fit of every point's weight over the fractional position, in powers of (frac - 0.5)
+    std::array<std::array<float, SincInterpolator::numPoints>, SincInterpolator::order + 1> fitSincCoefficients()
+    {
+        const int numPoints = SincInterpolator::numPoints;
+        const int numTerms = SincInterpolator::order + 1;
+        const int numFracs = 256;
+
+        double normal[numTerms][numTerms] = {};
+        double rightHandSide[numTerms][numPoints] = {};
+
+        for(int i = 0; i <= numFracs; i++) {
+            const double frac = (double) i / (double) numFracs;
+            const double u = frac - 0.5;
+
+            double weights[numPoints];
+            double weightSum = 0;
+
+            for(int k = 0; k < numPoints; k++) {
+                weights[k] = getWindowedSinc(frac - (double) (k + SincInterpolator::firstPoint));
+                weightSum += weights[k];
+            }
+
+            // Normalising so DC passes at unity gain for every position
+            double powers[numTerms];
+            powers[0] = 1.0;
+
+            for(int m = 1; m < numTerms; m++) {
+                powers[m] = powers[m - 1] * u;
+            }
+
+            for(int m = 0; m < numTerms; m++) {
+                for(int n = 0; n < numTerms; n++) {
+                    normal[m][n] += powers[m] * powers[n];
+                }
+
+                for(int k = 0; k < numPoints; k++) {
+                    rightHandSide[m][k] += powers[m] * weights[k] / weightSum;
+                }
+            }
+        }
+
+        // Solving the normal equations for all points at once with Gauss-Jordan elimination
+        for(int pivot = 0; pivot < numTerms; pivot++) {
+            const double scale = 1.0 / normal[pivot][pivot];
+
+            for(int n = 0; n < numTerms; n++) {
+                normal[pivot][n] *= scale;
+            }
+
+            for(int k = 0; k < numPoints; k++) {
+                rightHandSide[pivot][k] *= scale;
+            }
+
+            for(int row = 0; row < numTerms; row++) {
+                if(row == pivot) {
+                    continue;
+                }
+
+                const double factor = normal[row][pivot];
+
+                for(int n = 0; n < numTerms; n++) {
+                    normal[row][n] -= factor * normal[pivot][n];
+                }
+
+                for(int k = 0; k < numPoints; k++) {
+                    rightHandSide[row][k] -= factor * rightHandSide[pivot][k];
+                }
+            }
+        }
+
+        std::array<std::array<float, SincInterpolator::numPoints>, SincInterpolator::order + 1> coefficients;
+
+        for(int m = 0; m < numTerms; m++) {
+            for(int k = 0; k < numPoints; k++) {
+                coefficients[(size_t) m][(size_t) k] = (float) rightHandSide[m][k];
+            }
+        }
+
+        return coefficients;
+    }
+}
+
+//==============================================================================
+const std::array<std::array<float, SincInterpolator::numPoints>, SincInterpolator::order + 1> SincInterpolator::coefficients = fitSincCoefficients();
@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    Interpolators.h
+
+    Fractional delay interpolators for the chorus kernel. Each one is a small
+    policy struct, so the kernel instantiates its inner loop once per
+    interpolator and the per-sample path never branches on the mode.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Matches the order of the processor's interpolation parameter. */
+enum class InterpolationType
+{
+    linear = 0,
+    lagrange,
+    allpass,
+    sinc
+};
+
+static constexpr int numInterpolationTypes = 4;
+
+inline juce::StringArray getInterpolationTypeNames()
+{
+    return { "Linear", "Lagrange", "Allpass", "Sinc" };
+}
+
+//==============================================================================
+/*
+    Every interpolator reads numPoints consecutive delay line samples starting
+    at firstPoint relative to the integer part of the read head, and is handed
+    the fractional part. The same code runs on plain floats for the scalar path
+    and on SIMDRegisters for the tap groups, so constants only ever appear on the
+    right hand side of an operator.
+
+    state holds one value per tap between samples, only the allpass uses it.
+    usesState tells the kernel whether consecutive samples of a tap depend on
+    each other, so whether they can be interpolated side by side.
+*/
+
+inline float reciprocal(float value)
+{
+    return 1.0f / value;
+}
+
+inline juce::dsp::SIMDRegister<float> reciprocal(juce::dsp::SIMDRegister<float> value)
+{
+    // SIMDRegister has no division, the lanes are divided one by one
+    for(size_t lane = 0; lane < juce::dsp::SIMDRegister<float>::SIMDNumElements; lane++) {
+        value.set(lane, 1.0f / value.get(lane));
+    }
+
+    return value;
+}
+
+/** Straight line between the two neighbouring samples, cheap but dulls the highs. */
+struct LinearInterpolator
+{
+    static constexpr int firstPoint = 0;
+    static constexpr int numPoints = 2;
+    static constexpr bool usesState = false;
+
+    template <typename Type>
+    static Type interpolate(const Type* points, Type frac, Type& /*state*/)
+    {
+        return points[0] + frac * (points[1] - points[0]);
+    }
+};
+
+/** Third order Lagrange polynomial through the four samples around the read head. */
+struct LagrangeInterpolator
+{
+    static constexpr int firstPoint = -1;
+    static constexpr int numPoints = 4;
+    static constexpr bool usesState = false;
+
+    template <typename Type>
+    static Type interpolate(const Type* points, Type frac, Type& /*state*/)
+    {
+        // The read head sits at 1 + frac between points[1] and points[2]
+        const Type d1 = frac;
+        const Type d2 = frac - 1.0f;
+        const Type d3 = frac - 2.0f;
+        const Type t = frac + 1.0f;
+
+        const Type c0 = d1 * d2 * d3 * (-1.0f / 6.0f);
+        const Type c1 = d2 * d3 * 0.5f;
+        const Type c2 = d1 * d3 * -0.5f;
+        const Type c3 = d1 * d2 * (1.0f / 6.0f);
+
+        return points[0] * c0 + t * (points[1] * c1 + points[2] * c2 + points[3] * c3);
+    }
+};
+
+/**
+    First order allpass with a flat magnitude response. The fractional delay
+    is kept within (1, 2] samples, so the coefficient stays within [-1/3, 0)
+    and the filter never rings.
+*/
+struct AllpassInterpolator
+{
+    static constexpr int firstPoint = 1;
+    static constexpr int numPoints = 2;
+    static constexpr bool usesState = true;
+
+    template <typename Type>
+    static Type interpolate(const Type* points, Type frac, Type& state)
+    {
+        // Delay of 2 - frac behind the newer point, a = (1 - delay) / (1 + delay)
+        const Type a = (frac - 1.0f) * reciprocal(frac - 3.0f) * -1.0f;
+
+        state = points[0] + a * (points[1] - state);
+        return state;
+    }
+};
+
+/**
+    Blackman windowed sinc over eight samples. The coefficient of every point
+    is a fifth order polynomial in the fractional position (a Farrow structure),
+    fitted to the windowed sinc once at startup, so no table is looked up per tap.
+*/
+struct SincInterpolator
+{
+    static constexpr int firstPoint = -3;
+    static constexpr int numPoints = 8;
+    static constexpr bool usesState = false;
+    static constexpr int order = 5;
+
+    /** coefficients[m][k] is the u^m term of point k's weight, with u = frac - 0.5. */
+    static const std::array<std::array<float, numPoints>, order + 1> coefficients;
+
+    template <typename Type>
+    static Type interpolate(const Type* points, Type frac, Type& /*state*/)
+    {
+        const Type u = frac - 0.5f;
+
+        Type result = weightedSum(points, order);
+
+        for(int m = order - 1; m >= 0; m--) {
+            result = result * u + weightedSum(points, m);
+        }
+
+        return result;
+    }
+
+private:
+    template <typename Type>
+    static Type weightedSum(const Type* points, int m)
+    {
+        Type sum = points[0] * coefficients[(size_t) m][0];
+
+        for(int k = 1; k < numPoints; k++) {
+            sum = sum + points[k] * coefficients[(size_t) m][(size_t) k];
+        }
+
+        return sum;
+    }
+};
+
+/** Samples any interpolator may read past either side of the two linear points. */
+static constexpr int maxInterpolationPoints = SincInterpolator::numPoints;
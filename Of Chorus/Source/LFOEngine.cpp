@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    LFOEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "LFOEngine.h"
+
+//==============================================================================
+LFOEngine::LFOEngine()
+{
+    mSampleRate = 44100.0;
+    mRate = 0;
+
+    mPhase = 0;
+    mPhaseIncrement = 0;
+
+    mRotationSin = 0;
+    mRotationCos = 1;
+
+    reset();
+}
+
+void LFOEngine::prepare(double sampleRate)
+{
+    mSampleRate = sampleRate;
+
+    // Forcing the rotation to be recalculated for the new sample rate
+    const double rate = mRate;
+    mRate = -1;
+    setRate((float) rate);
+
+    reset();
+}
+
+void LFOEngine::reset()
+{
+    mPhase = 0;
+    resync();
+}
+
+void LFOEngine::setRate(float rateHz)
+{
+    if(juce::exactlyEqual((double) rateHz, mRate)) {
+        return;
+    }
+
+    mRate = rateHz;
+    mPhaseIncrement = mRate / mSampleRate;
+
+    mRotationSin = std::sin(juce::MathConstants<double>::twoPi * mPhaseIncrement);
+    mRotationCos = std::cos(juce::MathConstants<double>::twoPi * mPhaseIncrement);
+}
+
+void LFOEngine::resync()
+{
+    mSin = std::sin(juce::MathConstants<double>::twoPi * mPhase);
+    mCos = std::cos(juce::MathConstants<double>::twoPi * mPhase);
+    mSamplesSinceResync = 0;
+}
+
+void LFOEngine::process(float* sinOut, float* cosOut, int numSamples)
+{
+    double s = mSin;
+    double c = mCos;
+
+    for(int i = 0; i < numSamples; i++) {
+        sinOut[i] = (float) s;
+        cosOut[i] = (float) c;
+
+        // Rotating the (cos, sin) pair by one phase increment
+        const double nextSin = s * mRotationCos + c * mRotationSin;
+        c = c * mRotationCos - s * mRotationSin;
+        s = nextSin;
+    }
+
+    mSin = s;
+    mCos = c;
+
+    // Advancing the double precision phase the oscillator is resynced from
+    mPhase += mPhaseIncrement * numSamples;
+    mPhase -= std::floor(mPhase);
+
+    mSamplesSinceResync += numSamples;
+
+    if(mSamplesSinceResync >= resyncInterval) {
+        resync();
+    }
+}
+
+void LFOEngine::skip(int numSamples)
+{
+    mPhase += mPhaseIncrement * numSamples;
+    mPhase -= std::floor(mPhase);
+
+    resync();
+}
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    LFOEngine.h
+
+    Sine LFO that renders a whole block of modulation values at once with a
+    quadrature recursive oscillator.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Produces sin and cos of the LFO phase for every sample of a block. Any
+    phase offset can be derived from the pair without another sin call:
+    sin(x + offset) = sin(x) * cos(offset) + cos(x) * sin(offset).
+
+    The phase is accumulated in double precision and the oscillator is resynced
+    from it regularly, so neither the frequency nor the amplitude drift over
+    long renders.
+*/
+class LFOEngine
+{
+public:
+    LFOEngine();
+
+    void prepare(double sampleRate);
+    void reset();
+
+    void setRate(float rateHz);
+
+    void process(float* sinOut, float* cosOut, int numSamples);
+
+    /** Advances the phase as if numSamples had been rendered, without rendering them. */
+    void skip(int numSamples);
+
+    double getPhase() const { return mPhase; }
+
+    /** The values process() will write first on its next call. */
+    float getNextSin() const { return (float) mSin; }
+    float getNextCos() const { return (float) mCos; }
+
+    /** The value of the sample before those, the last one process() or skip() went past. */
+    float getPreviousSin() const { return (float) (mSin * mRotationCos - mCos * mRotationSin); }
+
+    static constexpr int resyncInterval = 1024;
+
+private:
+    void resync();
+
+    double mSampleRate;
+    double mRate;
+
+    double mPhase;
+    double mPhaseIncrement;
+
+    double mSin;
+    double mCos;
+
+    double mRotationSin;
+    double mRotationCos;
+
+    int mSamplesSinceResync;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LFOEngine)
+};
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    OfChorusLookAndFeel.cpp
+
+  ==============================================================================
+*/
+
+#include "OfChorusLookAndFeel.h"
+
+//==============================================================================
+OfChorusLookAndFeel::OfChorusLookAndFeel()
+{
+    setColour(juce::Slider::rotarySliderFillColourId, juce::Colours::limegreen);
+    setColour(juce::Slider::thumbColourId, juce::Colours::white);
+}
+
+const juce::Image& OfChorusLookAndFeel::getKnobImage(int diameter, float scale, float rotaryStartAngle, float rotaryEndAngle)
+{
+    const auto key = std::make_pair(diameter, juce::roundToInt(scale * 100.0f));
+    auto found = mKnobImages.find(key);
+
+    if(found != mKnobImages.end()) {
+        return found->second;
+    }
+
+    if((int) mKnobImages.size() >= maxCachedKnobImages) {
+        mKnobImages.clear();
+    }
+
+    // Rendering the body and scale at the display's pixel density
+    const int pixels = juce::jmax(1, juce::roundToInt((float) diameter * scale));
+    juce::Image image(juce::Image::ARGB, pixels, pixels, true);
+    {
+        juce::Graphics g(image);
+        g.addTransform(juce::AffineTransform::scale(scale));
+
+        const auto bounds = juce::Rectangle<float>(0.0f, 0.0f, (float) diameter, (float) diameter).reduced(2.0f);
+        const auto body = bounds.reduced(bounds.getWidth() * 0.15f);
+        const auto centre = bounds.getCentre();
+
+        // Scale ticks around the rotary range
+        g.setColour(juce::Colours::grey);
+
+        for(int tick = 0; tick <= 10; tick++) {
+            const float angle = juce::jmap((float) tick, 0.0f, 10.0f, rotaryStartAngle, rotaryEndAngle);
+            const auto outer = centre.getPointOnCircumference(bounds.getWidth() * 0.5f, angle);
+            const auto inner = centre.getPointOnCircumference(bounds.getWidth() * 0.42f, angle);
+
+            g.drawLine({ inner, outer }, 1.0f);
+        }
+
+        g.setGradientFill(juce::ColourGradient(juce::Colour(0xff4a4a4a), body.getX(), body.getY(),
+                                               juce::Colour(0xff1c1c1c), body.getRight(), body.getBottom(), false));
+        g.fillEllipse(body);
+
+        g.setColour(juce::Colours::black);
+        g.drawEllipse(body, 1.0f);
+    }
+
+    return mKnobImages[key] = image;
+}
+
+void OfChorusLookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPosProportional,
+                                           float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider)
+{
+    const int diameter = juce::jmin(width, height);
+    const auto area = juce::Rectangle<int>(x, y, width, height).withSizeKeepingCentre(diameter, diameter).toFloat();
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    g.drawImage(getKnobImage(diameter, scale, rotaryStartAngle, rotaryEndAngle), area);
+
+    // Only the value arc and pointer change with the value
+    const auto centre = area.getCentre();
+    const float radius = area.getWidth() * 0.5f - 2.0f;
+    const float angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
+
+    juce::Path arc;
+    arc.addCentredArc(centre.x, centre.y, radius * 0.78f, radius * 0.78f, 0.0f, rotaryStartAngle, angle, true);
+
+    g.setColour(slider.findColour(juce::Slider::rotarySliderFillColourId));
+    g.strokePath(arc, juce::PathStrokeType(2.5f, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+
+    g.setColour(slider.findColour(juce::Slider::thumbColourId));
+    g.drawLine({ centre.getPointOnCircumference(radius * 0.2f, angle), centre.getPointOnCircumference(radius * 0.6f, angle) }, 2.0f);
+}
@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    OfChorusLookAndFeel.h
+
+    Draws the rotary knobs from artwork rendered once per size and display
+    scale, so moving a knob only redraws its pointer over a cached image.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <map>
+
+//==============================================================================
+/**
+*/
+class OfChorusLookAndFeel  : public juce::LookAndFeel_V4
+{
+public:
+    OfChorusLookAndFeel();
+
+    void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPosProportional,
+                          float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider) override;
+
+    /** Resizing the editor creates a new size on every step, older sizes are dropped past this. */
+    static constexpr int maxCachedKnobImages = 16;
+
+private:
+    const juce::Image& getKnobImage(int diameter, float scale, float rotaryStartAngle, float rotaryEndAngle);
+
+    // Keyed by diameter and display scale in percent, every knob uses the same rotary range
+    std::map<std::pair<int, int>, juce::Image> mKnobImages;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfChorusLookAndFeel)
+};
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    ParameterCrossfade.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterCrossfade.h"
+
+//==============================================================================
+ParameterCrossfade::ParameterCrossfade()
+{
+    mFadeSamples = 0;
+    mHoldSamples = 0;
+    mPhase = Phase::idle;
+    mPhaseSamples = 0;
+    mElapsedSamples = 0;
+    mStart = {};
+    mLast = {};
+    mHasLast = false;
+}
+
+void ParameterCrossfade::prepare(double sampleRate)
+{
+    // The wet signal has to sit at zero for a whole smoothing time before the type switches,
+    // and the kernel only starts ramping towards a new snapshot when its next chunk starts
+    mHoldSamples = juce::roundToInt(ChorusKernel::smoothingTimeSeconds * sampleRate) + ChorusKernel::chunkSize;
+    mFadeSamples = juce::jmax(1, juce::roundToInt(crossfadeSeconds * sampleRate) - mHoldSamples) / 2;
+    
+    mPhase = Phase::idle;
+    mHasLast = false;
+}
+
+void ParameterCrossfade::start()
+{
+    // Nothing was processed yet, so there is nothing to glide from
+    if(! mHasLast) {
+        return;
+    }
+    
+    mStart = mLast;
+    mPhase = Phase::fadeOut;
+    mPhaseSamples = 0;
+    mElapsedSamples = 0;
+}
+
+ChorusKernel::Parameters ParameterCrossfade::process(const ChorusKernel::Parameters& target, int numSamples)
+{
+    ChorusKernel::Parameters parameters = target;
+    
+    // Switching the type straight away would jump every read head at once, and a switch
+    // that arrives while the last one fades in starts over from where that fade is.
+    // Voices and interpolation go straight through, the kernel switches them between chunks
+    if((mPhase == Phase::idle || mPhase == Phase::fadeIn) && mHasLast && ! hasSameType(mLast, target)) {
+        start();
+    }
+    
+    if(mPhase != Phase::idle) {
+        // Aiming for where the glide is at the end of this block, the kernel ramps there
+        mPhaseSamples += numSamples;
+        mElapsedSamples += numSamples;
+        
+        // Once the wet signal is fading for a type switch it finishes that way
+        const bool switchType = mPhase != Phase::fadeOut || ! hasSameType(mStart, target);
+        const int totalSamples = switchType ? 2 * mFadeSamples + mHoldSamples : 2 * mFadeSamples;
+        
+        const float progress = juce::jmin(1.0f, (float) mElapsedSamples / (float) totalSamples);
+        
+        parameters.depth = juce::jmap(progress, mStart.depth, target.depth);
+        parameters.rate = juce::jmap(progress, mStart.rate, target.rate);
+        parameters.phaseOffset = juce::jmap(progress, mStart.phaseOffset, target.phaseOffset);
+        parameters.feedback = juce::jmap(progress, mStart.feedback, target.feedback);
+        parameters.envelopeDepth = juce::jmap(progress, mStart.envelopeDepth, target.envelopeDepth);
+        parameters.envelopeRate = juce::jmap(progress, mStart.envelopeRate, target.envelopeRate);
+        
+        // The envelope's share of the mix fades along with the rest of it
+        if(! switchType) {
+            parameters.dryWet = juce::jmap(progress, mStart.dryWet, target.dryWet);
+            parameters.envelopeMix = juce::jmap(progress, mStart.envelopeMix, target.envelopeMix);
+            
+            if(progress >= 1.0f) {
+                mPhase = Phase::idle;
+            }
+        }
+        else if(mPhase == Phase::fadeOut) {
+            // Keeping the old type until the wet signal is gone
+            const float fade = juce::jmin(1.0f, (float) mPhaseSamples / (float) mFadeSamples);
+            
+            parameters.dryWet = mStart.dryWet * (1.0f - fade);
+            parameters.envelopeMix = mStart.envelopeMix * (1.0f - fade);
+            parameters.type = mStart.type;
+            
+            if(mPhaseSamples >= mFadeSamples) {
+                mPhase = Phase::hold;
+                mPhaseSamples = 0;
+            }
+        }
+        else if(mPhase == Phase::hold) {
+            // The hold only counts once a whole block has run with the wet target at zero
+            parameters.dryWet = 0.0f;
+            parameters.envelopeMix = 0.0f;
+            parameters.type = mStart.type;
+            
+            if(mPhaseSamples - numSamples >= mHoldSamples) {
+                mPhase = Phase::fadeIn;
+                mPhaseSamples = 0;
+                parameters.type = target.type;
+            }
+        }
+        else {
+            const float fade = juce::jmin(1.0f, (float) mPhaseSamples / (float) mFadeSamples);
+            
+            parameters.dryWet = target.dryWet * fade;
+            parameters.envelopeMix = target.envelopeMix * fade;
+            
+            if(mPhaseSamples >= mFadeSamples) {
+                mPhase = Phase::idle;
+            }
+        }
+    }
+    
+    mLast = parameters;
+    mHasLast = true;
+    
+    return parameters;
+}
+
+bool ParameterCrossfade::hasSameType(const ChorusKernel::Parameters& a, const ChorusKernel::Parameters& b)
+{
+    return a.type == b.type;
+}
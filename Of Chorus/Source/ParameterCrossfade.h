@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    ParameterCrossfade.h
+
+    Glides the kernel's parameters from one preset to the next inside
+    processBlock. Continuous parameters move linearly across the crossfade.
+    The type moves every delay time at once, so a type switch is not a
+    crossfade but a dip through the dry signal: the wet signal fades out,
+    is held silent while the type switches, and fades back in. A type
+    change outside a preset switch, from automation or the editor, dips the
+    same way, and one that arrives while the wet signal is fading back in
+    starts a new dip from there. Voices and interpolation are handed
+    straight to the kernel, which switches them where its next chunk starts.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusKernel.h"
+
+//==============================================================================
+/**
+    Audio thread only. Holds no buffers, so starting a crossfade never
+    allocates.
+*/
+class ParameterCrossfade
+{
+public:
+    ParameterCrossfade();
+
+    void prepare(double sampleRate);
+
+    /** Starts gliding away from the parameters the kernel was last given. */
+    void start();
+
+    /** Returns what to hand the kernel for the next numSamples, given the parameters' current values. */
+    ChorusKernel::Parameters process(const ChorusKernel::Parameters& target, int numSamples);
+
+    bool isActive() const { return mPhase != Phase::idle; }
+
+    static constexpr double crossfadeSeconds = 0.1;
+
+private:
+    enum class Phase
+    {
+        idle,
+        fadeOut,
+        hold,
+        fadeIn
+    };
+
+    static bool hasSameType(const ChorusKernel::Parameters& a, const ChorusKernel::Parameters& b);
+
+    int mFadeSamples;
+    int mHoldSamples;
+
+    Phase mPhase;
+    int mPhaseSamples;
+    int mElapsedSamples;
+
+    ChorusKernel::Parameters mStart;
+    ChorusKernel::Parameters mLast;
+    bool mHasLast;
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    ParameterSync.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterSync.h"
+
+//==============================================================================
+ParameterSync::ParameterSync(juce::AudioProcessor& processor)
+{
+    for(auto* parameter : processor.getParameters()) {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+        jassert(ranged != nullptr);
+        
+        mParameters.push_back(ranged);
+        ranged->addListener(this);
+    }
+    
+    jassert((int) mParameters.size() <= maxParameters);
+    
+    mDirty = 0;
+    mPending = 0;
+    mGestures = 0;
+    
+    for(float& value : mPendingValues) {
+        value = 0.0f;
+    }
+}
+
+ParameterSync::~ParameterSync()
+{
+    for(auto* parameter : mParameters) {
+        parameter->removeListener(this);
+    }
+}
+
+void ParameterSync::setValue(int index, float value)
+{
+    mPendingValues[index] = value;
+    mPending |= 1u << index;
+}
+
+void ParameterSync::beginGesture(int index)
+{
+    mGestures |= 1u << index;
+    mParameters[(size_t) index]->beginChangeGesture();
+}
+
+void ParameterSync::endGesture(int index)
+{
+    sendValue(index);
+    
+    mGestures &= ~(1u << index);
+    mParameters[(size_t) index]->endChangeGesture();
+}
+
+void ParameterSync::flush()
+{
+    for(int index = 0; mPending != 0 && index < (int) mParameters.size(); index++) {
+        sendValue(index);
+    }
+}
+
+void ParameterSync::pollChanges(const std::function<void(int index, float value)>& onChange)
+{
+    juce::uint32 dirty = mDirty.exchange(0);
+    
+    // Holding back whatever the editor is still changing itself
+    const juce::uint32 held = dirty & (mPending | mGestures);
+    
+    if(held != 0) {
+        mDirty.fetch_or(held);
+        dirty &= ~held;
+    }
+    
+    for(int index = 0; dirty != 0; index++, dirty >>= 1) {
+        if(dirty & 1u) {
+            auto* parameter = mParameters[(size_t) index];
+            onChange(index, parameter->convertFrom0to1(parameter->getValue()));
+        }
+    }
+}
+
+void ParameterSync::sendValue(int index)
+{
+    const juce::uint32 bit = 1u << index;
+    
+    if((mPending & bit) == 0) {
+        return;
+    }
+    
+    mPending &= ~bit;
+    
+    auto* parameter = mParameters[(size_t) index];
+    const float normalised = parameter->convertTo0to1(mPendingValues[index]);
+    
+    // Dragging back and forth often ends where it started
+    if(! juce::exactlyEqual(normalised, parameter->getValue())) {
+        parameter->setValueNotifyingHost(normalised);
+    }
+}
+
+void ParameterSync::parameterValueChanged(int parameterIndex, float /*newValue*/)
+{
+    mDirty.fetch_or(1u << parameterIndex);
+}
+
+void ParameterSync::parameterGestureChanged(int /*parameterIndex*/, bool /*gestureIsStarting*/)
+{
+}
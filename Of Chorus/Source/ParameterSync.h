@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    ParameterSync.h
+
+    Keeps the editor's controls and the processor's parameters in step
+    without a round trip per change. Changes from the host or the audio
+    thread only set a bit, which the editor polls at display rate, and edits
+    from the editor are held back and sent to the host once per poll.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Listens to every parameter of a processor. parameterValueChanged() may be
+    called on any thread, so it does nothing but set the parameter's bit in an
+    atomic mask. Everything else is only ever called on the message thread.
+*/
+class ParameterSync  : private juce::AudioProcessorParameter::Listener
+{
+public:
+    /** One bit of the dirty mask per parameter. */
+    static constexpr int maxParameters = 32;
+
+    explicit ParameterSync(juce::AudioProcessor& processor);
+    ~ParameterSync() override;
+
+    /** Queues an edit in the parameter's own range, it reaches the host on the next flush(). */
+    void setValue(int index, float value);
+
+    /** Gestures are passed through, ending one sends its queued edit first. */
+    void beginGesture(int index);
+    void endGesture(int index);
+
+    /** Sends every queued edit to the host, once per parameter however often it was edited. */
+    void flush();
+
+    /**
+        Calls onChange with the index and current value of every parameter that
+        changed since the last poll. Parameters with queued edits or an open
+        gesture are left for a later poll, so a knob never jumps under the mouse.
+    */
+    void pollChanges(const std::function<void(int index, float value)>& onChange);
+
+    juce::RangedAudioParameter& getParameter(int index) const { return *mParameters[(size_t) index]; }
+
+private:
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+
+    void sendValue(int index);
+
+    std::vector<juce::RangedAudioParameter*> mParameters;
+
+    // Set from any thread, cleared by pollChanges()
+    std::atomic<juce::uint32> mDirty;
+
+    // Message thread only
+    float mPendingValues[maxParameters];
+    juce::uint32 mPending;
+    juce::uint32 mGestures;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterSync)
+};
@@ -1,153 +1,605 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-OfChorusAudioProcessorEditor::OfChorusAudioProcessorEditor (OfChorusAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
-{
-    // Make sure that before the constructor has finished, you've set the
-    // editor's size to whatever you need it to be.
-    setSize (400, 300);
-    
-    auto& params = processor.getParameters();
-    
-    // Setting up dry/wet slider
-    juce::AudioParameterFloat* dryWetParameter = (juce::AudioParameterFloat*) params.getUnchecked(0);
-    
-    mDryWetSlider.setBounds(0, 0, 100, 100);
-    mDryWetSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
-    mDryWetSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
-    mDryWetSlider.setRange(dryWetParameter->range.start, dryWetParameter->range.end);
-    mDryWetSlider.setValue(*dryWetParameter);
-    addAndMakeVisible(mDryWetSlider);
-    
-    mDryWetSlider.onValueChange = [this, dryWetParameter] {
-        *dryWetParameter = mDryWetSlider.getValue();
-    };
-    mDryWetSlider.onDragStart = [dryWetParameter] {
-        dryWetParameter->beginChangeGesture();
-    };
-    mDryWetSlider.onDragEnd = [dryWetParameter] {
-        dryWetParameter->endChangeGesture();
-    };
-    
-    // Setting up depth slider
-    juce::AudioParameterFloat* depthParameter = (juce::AudioParameterFloat*) params.getUnchecked(1);
-    
-    mDepthSlider.setBounds(100, 0, 100, 100);
-    mDepthSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
-    mDepthSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
-    mDepthSlider.setRange(depthParameter->range.start, depthParameter->range.end);
-    mDepthSlider.setValue(*depthParameter);
-    addAndMakeVisible(mDepthSlider);
-    
-    mDepthSlider.onValueChange = [this, depthParameter] {
-        *depthParameter = mDepthSlider.getValue();
-    };
-    mDepthSlider.onDragStart = [depthParameter] {
-        depthParameter->beginChangeGesture();
-    };
-    mDepthSlider.onDragEnd = [depthParameter] {
-        depthParameter->endChangeGesture();
-    };
-    
-    // Setting up rate slider
-    juce::AudioParameterFloat* rateParameter = (juce::AudioParameterFloat*) params.getUnchecked(2);
-    
-    mRateSlider.setBounds(200, 0, 100, 100);
-    mRateSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
-    mRateSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
-    mRateSlider.setRange(rateParameter->range.start, rateParameter->range.end);
-    mRateSlider.setValue(*rateParameter);
-    addAndMakeVisible(mRateSlider);
-    
-    mRateSlider.onValueChange = [this, rateParameter] {
-        *rateParameter = mRateSlider.getValue();
-    };
-    mRateSlider.onDragStart = [rateParameter] {
-        rateParameter->beginChangeGesture();
-    };
-    mRateSlider.onDragEnd = [rateParameter] {
-        rateParameter->endChangeGesture();
-    };
-    
-    // Setting up phase offset slider
-    juce::AudioParameterFloat* phaseOffsetParameter = (juce::AudioParameterFloat*) params.getUnchecked(3);
-    
-    mPhaseOffsetSlider.setBounds(300, 0, 100, 100);
-    mPhaseOffsetSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
-    mPhaseOffsetSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
-    mPhaseOffsetSlider.setRange(phaseOffsetParameter->range.start, phaseOffsetParameter->range.end);
-    mPhaseOffsetSlider.setValue(*phaseOffsetParameter);
-    addAndMakeVisible(mPhaseOffsetSlider);
-    
-    mPhaseOffsetSlider.onValueChange = [this, phaseOffsetParameter] {
-        *phaseOffsetParameter = mPhaseOffsetSlider.getValue();
-    };
-    mPhaseOffsetSlider.onDragStart = [phaseOffsetParameter] {
-        phaseOffsetParameter->beginChangeGesture();
-    };
-    mPhaseOffsetSlider.onDragEnd = [phaseOffsetParameter] {
-        phaseOffsetParameter->endChangeGesture();
-    };
-    
-    // Setting up feedback slider
-    juce::AudioParameterFloat* feedbackParameter = (juce::AudioParameterFloat*) params.getUnchecked(4);
-    
-    mFeedbackSlider.setBounds(0, 100, 100, 100);
-    mFeedbackSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
-    mFeedbackSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
-    mFeedbackSlider.setRange(feedbackParameter->range.start, feedbackParameter->range.end);
-    mFeedbackSlider.setValue(*feedbackParameter);
-    addAndMakeVisible(mFeedbackSlider);
-    
-    mFeedbackSlider.onValueChange = [this, feedbackParameter] {
-        *feedbackParameter = mFeedbackSlider.getValue();
-    };
-    mFeedbackSlider.onDragStart = [feedbackParameter] {
-        feedbackParameter->beginChangeGesture();
-    };
-    mFeedbackSlider.onDragEnd = [feedbackParameter] {
-        feedbackParameter->endChangeGesture();
-    };
-    
-    juce::AudioParameterInt* typeParameter = (juce::AudioParameterInt*) params.getUnchecked(5);
-    
-    mType.setBounds(100, 100, 100, 30);
-    mType.addItem("Chorus", 1);
-    mType.addItem("Flanger", 2);
-    addAndMakeVisible(mType);
-    
-    mType.onChange = [this, typeParameter] {
-        typeParameter->beginChangeGesture();
-        *typeParameter = mType.getSelectedItemIndex();
-        typeParameter->endChangeGesture();
-    };
-    
-    mType.setSelectedItemIndex(*typeParameter);
-}
-
-OfChorusAudioProcessorEditor::~OfChorusAudioProcessorEditor()
-{
-}
-
-//==============================================================================
-void OfChorusAudioProcessorEditor::paint (juce::Graphics& g)
-{
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-}
-
-void OfChorusAudioProcessorEditor::resized()
-{
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+namespace
+{
+    // Every control's place in the unscaled layout, resized() scales these to the editor's size
+    const juce::Rectangle<int> dryWetBounds(0, 0, 100, 100);
+    const juce::Rectangle<int> depthBounds(100, 0, 100, 100);
+    const juce::Rectangle<int> rateBounds(200, 0, 100, 100);
+    const juce::Rectangle<int> phaseOffsetBounds(300, 0, 100, 100);
+    const juce::Rectangle<int> feedbackBounds(0, 100, 100, 100);
+    const juce::Rectangle<int> typeBounds(100, 100, 100, 50);
+    const juce::Rectangle<int> interpolationBounds(100, 150, 100, 50);
+    const juce::Rectangle<int> voicesBounds(200, 100, 100, 100);
+    const juce::Rectangle<int> presetBounds(300, 100, 100, 50);
+    const juce::Rectangle<int> savePresetBounds(300, 150, 100, 50);
+    const juce::Rectangle<int> envelopeDetectorBounds(0, 200, 80, 100);
+    const juce::Rectangle<int> envelopeAttackBounds(80, 200, 64, 100);
+    const juce::Rectangle<int> envelopeReleaseBounds(144, 200, 64, 100);
+    const juce::Rectangle<int> envelopeDepthBounds(208, 200, 64, 100);
+    const juce::Rectangle<int> envelopeRateBounds(272, 200, 64, 100);
+    const juce::Rectangle<int> envelopeMixBounds(336, 200, 64, 100);
+   #if OF_CHORUS_PROFILING
+    const juce::Rectangle<int> scopeBounds(0, 300, 320, 80);
+    const juce::Rectangle<int> cpuLoadBounds(0, 380, 220, 20);
+    const juce::Rectangle<int> resetProfileBounds(220, 380, 50, 20);
+    const juce::Rectangle<int> exportProfileBounds(270, 380, 50, 20);
+   #else
+    const juce::Rectangle<int> scopeBounds(0, 300, 320, 100);
+   #endif
+    const juce::Rectangle<int> meterBounds(320, 300, 80, 100);
+
+    // The bottom of every knob's cell holds its label
+    const int labelHeight = 18;
+}
+
+//==============================================================================
+OfChorusAudioProcessorEditor::OfChorusAudioProcessorEditor (OfChorusAudioProcessor& p)
+    : AudioProcessorEditor (&p), audioProcessor (p), mParameterSync (p)
+{
+    setLookAndFeel(&mLookAndFeel);
+    setOpaque(true);
+    
+    mBackgroundPixelScale = 1.0f;
+    
+    auto& params = processor.getParameters();
+    
+    // Setting up dry/wet slider
+    juce::AudioParameterFloat* dryWetParameter = (juce::AudioParameterFloat*) params.getUnchecked(0);
+    
+    mDryWetSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mDryWetSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mDryWetSlider.setRange(dryWetParameter->range.start, dryWetParameter->range.end);
+    mDryWetSlider.setValue(*dryWetParameter);
+    addAndMakeVisible(mDryWetSlider);
+    
+    mDryWetSlider.onValueChange = [this] {
+        mParameterSync.setValue(0, (float) mDryWetSlider.getValue());
+    };
+    mDryWetSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(0);
+    };
+    mDryWetSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(0);
+    };
+    
+    // Setting up depth slider
+    juce::AudioParameterFloat* depthParameter = (juce::AudioParameterFloat*) params.getUnchecked(1);
+    
+    mDepthSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mDepthSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mDepthSlider.setRange(depthParameter->range.start, depthParameter->range.end);
+    mDepthSlider.setValue(*depthParameter);
+    addAndMakeVisible(mDepthSlider);
+    
+    mDepthSlider.onValueChange = [this] {
+        mParameterSync.setValue(1, (float) mDepthSlider.getValue());
+    };
+    mDepthSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(1);
+    };
+    mDepthSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(1);
+    };
+    
+    // Setting up rate slider
+    juce::AudioParameterFloat* rateParameter = (juce::AudioParameterFloat*) params.getUnchecked(2);
+    
+    mRateSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mRateSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mRateSlider.setRange(rateParameter->range.start, rateParameter->range.end);
+    mRateSlider.setValue(*rateParameter);
+    addAndMakeVisible(mRateSlider);
+    
+    mRateSlider.onValueChange = [this] {
+        mParameterSync.setValue(2, (float) mRateSlider.getValue());
+    };
+    mRateSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(2);
+    };
+    mRateSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(2);
+    };
+    
+    // Setting up phase offset slider
+    juce::AudioParameterFloat* phaseOffsetParameter = (juce::AudioParameterFloat*) params.getUnchecked(3);
+    
+    mPhaseOffsetSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mPhaseOffsetSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mPhaseOffsetSlider.setRange(phaseOffsetParameter->range.start, phaseOffsetParameter->range.end);
+    mPhaseOffsetSlider.setValue(*phaseOffsetParameter);
+    addAndMakeVisible(mPhaseOffsetSlider);
+    
+    mPhaseOffsetSlider.onValueChange = [this] {
+        mParameterSync.setValue(3, (float) mPhaseOffsetSlider.getValue());
+    };
+    mPhaseOffsetSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(3);
+    };
+    mPhaseOffsetSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(3);
+    };
+    
+    // Setting up feedback slider
+    juce::AudioParameterFloat* feedbackParameter = (juce::AudioParameterFloat*) params.getUnchecked(4);
+    
+    mFeedbackSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mFeedbackSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mFeedbackSlider.setRange(feedbackParameter->range.start, feedbackParameter->range.end);
+    mFeedbackSlider.setValue(*feedbackParameter);
+    addAndMakeVisible(mFeedbackSlider);
+    
+    mFeedbackSlider.onValueChange = [this] {
+        mParameterSync.setValue(4, (float) mFeedbackSlider.getValue());
+    };
+    mFeedbackSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(4);
+    };
+    mFeedbackSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(4);
+    };
+    
+    juce::AudioParameterInt* typeParameter = (juce::AudioParameterInt*) params.getUnchecked(5);
+    
+    mType.addItemList(getEffectTypeNames(), 1);
+    addAndMakeVisible(mType);
+    
+    mType.setSelectedItemIndex(*typeParameter, juce::dontSendNotification);
+    
+    mType.onChange = [this] {
+        mParameterSync.beginGesture(5);
+        mParameterSync.setValue(5, (float) mType.getSelectedItemIndex());
+        mParameterSync.endGesture(5);
+    };
+    
+    // Setting up voices slider
+    juce::AudioParameterInt* voicesParameter = (juce::AudioParameterInt*) params.getUnchecked(6);
+    
+    mVoicesSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mVoicesSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mVoicesSlider.setRange(voicesParameter->getRange().getStart(), voicesParameter->getRange().getEnd(), 1);
+    mVoicesSlider.setValue(*voicesParameter);
+    addAndMakeVisible(mVoicesSlider);
+    
+    mVoicesSlider.onValueChange = [this] {
+        mParameterSync.setValue(6, (float) mVoicesSlider.getValue());
+    };
+    mVoicesSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(6);
+    };
+    mVoicesSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(6);
+    };
+    
+    // Setting up interpolation selector
+    juce::AudioParameterInt* interpolationParameter = (juce::AudioParameterInt*) params.getUnchecked(7);
+    
+    mInterpolation.addItemList(getInterpolationTypeNames(), 1);
+    addAndMakeVisible(mInterpolation);
+    
+    mInterpolation.setSelectedItemIndex(*interpolationParameter, juce::dontSendNotification);
+    
+    mInterpolation.onChange = [this] {
+        mParameterSync.beginGesture(7);
+        mParameterSync.setValue(7, (float) mInterpolation.getSelectedItemIndex());
+        mParameterSync.endGesture(7);
+    };
+    
+    // Setting up envelope attack slider
+    juce::AudioParameterFloat* envelopeAttackParameter = (juce::AudioParameterFloat*) params.getUnchecked(8);
+    
+    mEnvelopeAttackSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mEnvelopeAttackSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mEnvelopeAttackSlider.setRange(envelopeAttackParameter->range.start, envelopeAttackParameter->range.end);
+    mEnvelopeAttackSlider.setValue(*envelopeAttackParameter);
+    addAndMakeVisible(mEnvelopeAttackSlider);
+    
+    mEnvelopeAttackSlider.onValueChange = [this] {
+        mParameterSync.setValue(8, (float) mEnvelopeAttackSlider.getValue());
+    };
+    mEnvelopeAttackSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(8);
+    };
+    mEnvelopeAttackSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(8);
+    };
+    
+    // Setting up envelope release slider
+    juce::AudioParameterFloat* envelopeReleaseParameter = (juce::AudioParameterFloat*) params.getUnchecked(9);
+    
+    mEnvelopeReleaseSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mEnvelopeReleaseSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mEnvelopeReleaseSlider.setRange(envelopeReleaseParameter->range.start, envelopeReleaseParameter->range.end);
+    mEnvelopeReleaseSlider.setValue(*envelopeReleaseParameter);
+    addAndMakeVisible(mEnvelopeReleaseSlider);
+    
+    mEnvelopeReleaseSlider.onValueChange = [this] {
+        mParameterSync.setValue(9, (float) mEnvelopeReleaseSlider.getValue());
+    };
+    mEnvelopeReleaseSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(9);
+    };
+    mEnvelopeReleaseSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(9);
+    };
+    
+    // Setting up envelope detector selector
+    juce::AudioParameterInt* envelopeDetectorParameter = (juce::AudioParameterInt*) params.getUnchecked(10);
+    
+    mEnvelopeDetector.addItemList(getEnvelopeDetectorNames(), 1);
+    addAndMakeVisible(mEnvelopeDetector);
+    
+    mEnvelopeDetector.setSelectedItemIndex(*envelopeDetectorParameter, juce::dontSendNotification);
+    
+    mEnvelopeDetector.onChange = [this] {
+        mParameterSync.beginGesture(10);
+        mParameterSync.setValue(10, (float) mEnvelopeDetector.getSelectedItemIndex());
+        mParameterSync.endGesture(10);
+    };
+    
+    // Setting up envelope to depth slider
+    juce::AudioParameterFloat* envelopeDepthParameter = (juce::AudioParameterFloat*) params.getUnchecked(11);
+    
+    mEnvelopeDepthSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mEnvelopeDepthSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mEnvelopeDepthSlider.setRange(envelopeDepthParameter->range.start, envelopeDepthParameter->range.end);
+    mEnvelopeDepthSlider.setValue(*envelopeDepthParameter);
+    addAndMakeVisible(mEnvelopeDepthSlider);
+    
+    mEnvelopeDepthSlider.onValueChange = [this] {
+        mParameterSync.setValue(11, (float) mEnvelopeDepthSlider.getValue());
+    };
+    mEnvelopeDepthSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(11);
+    };
+    mEnvelopeDepthSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(11);
+    };
+    
+    // Setting up envelope to rate slider
+    juce::AudioParameterFloat* envelopeRateParameter = (juce::AudioParameterFloat*) params.getUnchecked(12);
+    
+    mEnvelopeRateSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mEnvelopeRateSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mEnvelopeRateSlider.setRange(envelopeRateParameter->range.start, envelopeRateParameter->range.end);
+    mEnvelopeRateSlider.setValue(*envelopeRateParameter);
+    addAndMakeVisible(mEnvelopeRateSlider);
+    
+    mEnvelopeRateSlider.onValueChange = [this] {
+        mParameterSync.setValue(12, (float) mEnvelopeRateSlider.getValue());
+    };
+    mEnvelopeRateSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(12);
+    };
+    mEnvelopeRateSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(12);
+    };
+    
+    // Setting up envelope to mix slider
+    juce::AudioParameterFloat* envelopeMixParameter = (juce::AudioParameterFloat*) params.getUnchecked(13);
+    
+    mEnvelopeMixSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    mEnvelopeMixSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    mEnvelopeMixSlider.setRange(envelopeMixParameter->range.start, envelopeMixParameter->range.end);
+    mEnvelopeMixSlider.setValue(*envelopeMixParameter);
+    addAndMakeVisible(mEnvelopeMixSlider);
+    
+    mEnvelopeMixSlider.onValueChange = [this] {
+        mParameterSync.setValue(13, (float) mEnvelopeMixSlider.getValue());
+    };
+    mEnvelopeMixSlider.onDragStart = [this] {
+        mParameterSync.beginGesture(13);
+    };
+    mEnvelopeMixSlider.onDragEnd = [this] {
+        mParameterSync.endGesture(13);
+    };
+    
+    // Setting up preset selector, listing the shared bank's names
+    refreshPresetList();
+    addAndMakeVisible(mPreset);
+    
+    mPreset.onChange = [this] {
+        const int index = mPreset.getSelectedItemIndex();
+        
+        if(index >= 0 && index != audioProcessor.getCurrentProgram()) {
+            audioProcessor.setCurrentProgram(index);
+            audioProcessor.updateHostDisplay();
+        }
+    };
+    
+    mSavePreset.setButtonText("Save Preset");
+    addAndMakeVisible(mSavePreset);
+    
+    mSavePreset.onClick = [this] {
+        savePreset();
+    };
+    
+    // Setting up scope and meters, fed from the processor's telemetry on the display timer
+    addAndMakeVisible(mScope);
+    
+    mMeter.setNumChannels(juce::jmin(p.getTotalNumOutputChannels(), TelemetryFrame::maxMeterChannels));
+    addAndMakeVisible(mMeter);
+    
+   #if OF_CHORUS_PROFILING
+    // Setting up CPU load readout, reset and CSV export
+    mProfileTicks = 0;
+    mCpuLoad.setFont(juce::Font(12.0f));
+    mCpuLoad.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(mCpuLoad);
+    
+    mResetProfile.setButtonText("Reset");
+    mResetProfile.setTooltip("Start the CPU profile over from the next block");
+    addAndMakeVisible(mResetProfile);
+    
+    mResetProfile.onClick = [this] {
+        audioProcessor.getProfiler().reset();
+    };
+    
+    mExportProfile.setButtonText("CSV");
+    mExportProfile.setTooltip("Export the CPU profile of recent blocks");
+    addAndMakeVisible(mExportProfile);
+    
+    mExportProfile.onClick = [this] {
+        exportProfile();
+    };
+   #endif
+    
+    audioProcessor.setTelemetryEnabled(true);
+    startTimerHz(displayRefreshHz);
+    
+    // Make sure that before the constructor has finished, you've set the
+    // editor's size to whatever you need it to be.
+    setResizable(true, true);
+    setResizeLimits(baseWidth / 2, baseHeight / 2, baseWidth * 3, baseHeight * 3);
+    getConstrainer()->setFixedAspectRatio((double) baseWidth / (double) baseHeight);
+    setSize (baseWidth, baseHeight);
+}
+
+OfChorusAudioProcessorEditor::~OfChorusAudioProcessorEditor()
+{
+    stopTimer();
+    mParameterSync.flush();
+    audioProcessor.setTelemetryEnabled(false);
+    setLookAndFeel(nullptr);
+}
+
+//==============================================================================
+void OfChorusAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // Blitting the cached background, JUCE clips this to the region that actually changed
+    const float pixelScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if(! mBackground.isValid() || ! juce::exactlyEqual(pixelScale, mBackgroundPixelScale)) {
+        renderBackground(pixelScale);
+    }
+    
+    g.drawImage(mBackground, getLocalBounds().toFloat());
+}
+
+void OfChorusAudioProcessorEditor::renderBackground (float pixelScale)
+{
+    mBackgroundPixelScale = pixelScale;
+    mBackground = juce::Image(juce::Image::RGB,
+                              juce::jmax(1, juce::roundToInt((float) getWidth() * pixelScale)),
+                              juce::jmax(1, juce::roundToInt((float) getHeight() * pixelScale)),
+                              false);
+    
+    juce::Graphics g(mBackground);
+    
+    // Drawing in the unscaled layout's coordinates
+    g.addTransform(juce::AffineTransform::scale(pixelScale * getLayoutScale()));
+    
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+    
+    const std::pair<const char*, juce::Rectangle<int>> labels[] = {
+        { "Dry/Wet", dryWetBounds },
+        { "Depth", depthBounds },
+        { "Rate", rateBounds },
+        { "Phase Offset", phaseOffsetBounds },
+        { "Feedback", feedbackBounds },
+        { "Voices", voicesBounds },
+        { "Detector", envelopeDetectorBounds },
+        { "Attack", envelopeAttackBounds },
+        { "Release", envelopeReleaseBounds },
+        { "Env Depth", envelopeDepthBounds },
+        { "Env Rate", envelopeRateBounds },
+        { "Env Mix", envelopeMixBounds }
+    };
+    
+    g.setColour(juce::Colours::lightgrey);
+    g.setFont(13.0f);
+    
+    for(const auto& label : labels) {
+        g.drawText(label.first, label.second.withTop(label.second.getBottom() - labelHeight), juce::Justification::centred);
+    }
+    
+    g.setColour(juce::Colours::white.withAlpha(0.1f));
+    g.drawHorizontalLine(100, 0.0f, (float) baseWidth);
+    g.drawHorizontalLine(200, 0.0f, (float) baseWidth);
+    g.drawHorizontalLine(300, 0.0f, (float) baseWidth);
+}
+
+float OfChorusAudioProcessorEditor::getLayoutScale() const
+{
+    return (float) getWidth() / (float) baseWidth;
+}
+
+juce::Rectangle<int> OfChorusAudioProcessorEditor::scaled (juce::Rectangle<int> bounds) const
+{
+    return bounds.toFloat().transformedBy(juce::AffineTransform::scale(getLayoutScale())).getSmallestIntegerContainer();
+}
+
+void OfChorusAudioProcessorEditor::timerCallback()
+{
+    // Sending this tick's edits to the host, then catching up with automation
+    mParameterSync.flush();
+    mParameterSync.pollChanges([this] (int index, float value) {
+        updateControl(index, value);
+    });
+    
+    // Following program changes made by the host
+    if(mPreset.getSelectedItemIndex() != audioProcessor.getCurrentProgram()) {
+        mPreset.setSelectedItemIndex(audioProcessor.getCurrentProgram(), juce::dontSendNotification);
+    }
+    
+    // Draining everything the audio thread pushed since the last tick
+    TelemetryFrame frame;
+    
+    while(audioProcessor.getTelemetry().pop(frame)) {
+        mScope.pushFrame(frame);
+        mMeter.pushFrame(frame);
+    }
+    
+    mScope.tick();
+    mMeter.tick();
+    
+   #if OF_CHORUS_PROFILING
+    // The readout changes every block, a few updates a second are plenty to read it
+    if(++mProfileTicks >= displayRefreshHz / profileRefreshHz) {
+        mProfileTicks = 0;
+        updateCpuLoad();
+    }
+   #endif
+}
+
+void OfChorusAudioProcessorEditor::resized()
+{
+    // Scaling the fixed layout to the new size, knobs leave room for their labels in the background
+    const int scaledLabelHeight = juce::roundToInt((float) labelHeight * getLayoutScale());
+    
+    mDryWetSlider.setBounds(scaled(dryWetBounds).withTrimmedBottom(scaledLabelHeight));
+    mDepthSlider.setBounds(scaled(depthBounds).withTrimmedBottom(scaledLabelHeight));
+    mRateSlider.setBounds(scaled(rateBounds).withTrimmedBottom(scaledLabelHeight));
+    mPhaseOffsetSlider.setBounds(scaled(phaseOffsetBounds).withTrimmedBottom(scaledLabelHeight));
+    mFeedbackSlider.setBounds(scaled(feedbackBounds).withTrimmedBottom(scaledLabelHeight));
+    mVoicesSlider.setBounds(scaled(voicesBounds).withTrimmedBottom(scaledLabelHeight));
+    mEnvelopeAttackSlider.setBounds(scaled(envelopeAttackBounds).withTrimmedBottom(scaledLabelHeight));
+    mEnvelopeReleaseSlider.setBounds(scaled(envelopeReleaseBounds).withTrimmedBottom(scaledLabelHeight));
+    mEnvelopeDepthSlider.setBounds(scaled(envelopeDepthBounds).withTrimmedBottom(scaledLabelHeight));
+    mEnvelopeRateSlider.setBounds(scaled(envelopeRateBounds).withTrimmedBottom(scaledLabelHeight));
+    mEnvelopeMixSlider.setBounds(scaled(envelopeMixBounds).withTrimmedBottom(scaledLabelHeight));
+    
+    mType.setBounds(scaled(typeBounds).reduced(juce::roundToInt(8.0f * getLayoutScale())));
+    mInterpolation.setBounds(scaled(interpolationBounds).reduced(juce::roundToInt(8.0f * getLayoutScale())));
+    mPreset.setBounds(scaled(presetBounds).reduced(juce::roundToInt(8.0f * getLayoutScale())));
+    mSavePreset.setBounds(scaled(savePresetBounds).reduced(juce::roundToInt(8.0f * getLayoutScale())));
+    
+    // The detector sits where a knob would, above its label
+    mEnvelopeDetector.setBounds(scaled(envelopeDetectorBounds.withSizeKeepingCentre(80, 50)).reduced(juce::roundToInt(8.0f * getLayoutScale())));
+    
+    mScope.setBounds(scaled(scopeBounds));
+    
+   #if OF_CHORUS_PROFILING
+    mCpuLoad.setBounds(scaled(cpuLoadBounds));
+    mResetProfile.setBounds(scaled(resetProfileBounds).reduced(juce::roundToInt(2.0f * getLayoutScale())));
+    mExportProfile.setBounds(scaled(exportProfileBounds).reduced(juce::roundToInt(2.0f * getLayoutScale())));
+    mCpuLoad.setFont(juce::Font(12.0f * getLayoutScale()));
+   #endif
+    mMeter.setBounds(scaled(meterBounds));
+    
+    // The background is rendered again at the new size on the next paint
+    mBackground = juce::Image();
+}
+
+void OfChorusAudioProcessorEditor::updateControl (int index, float value)
+{
+    // Moving a control without notifying, so nothing is sent back to the host
+    switch(index) {
+        case 0: mDryWetSlider.setValue(value, juce::dontSendNotification); break;
+        case 1: mDepthSlider.setValue(value, juce::dontSendNotification); break;
+        case 2: mRateSlider.setValue(value, juce::dontSendNotification); break;
+        case 3: mPhaseOffsetSlider.setValue(value, juce::dontSendNotification); break;
+        case 4: mFeedbackSlider.setValue(value, juce::dontSendNotification); break;
+        case 5: mType.setSelectedItemIndex(juce::roundToInt(value), juce::dontSendNotification); break;
+        case 6: mVoicesSlider.setValue(value, juce::dontSendNotification); break;
+        case 7: mInterpolation.setSelectedItemIndex(juce::roundToInt(value), juce::dontSendNotification); break;
+        case 8: mEnvelopeAttackSlider.setValue(value, juce::dontSendNotification); break;
+        case 9: mEnvelopeReleaseSlider.setValue(value, juce::dontSendNotification); break;
+        case 10: mEnvelopeDetector.setSelectedItemIndex(juce::roundToInt(value), juce::dontSendNotification); break;
+        case 11: mEnvelopeDepthSlider.setValue(value, juce::dontSendNotification); break;
+        case 12: mEnvelopeRateSlider.setValue(value, juce::dontSendNotification); break;
+        case 13: mEnvelopeMixSlider.setValue(value, juce::dontSendNotification); break;
+        default: break;
+    }
+}
+
+void OfChorusAudioProcessorEditor::refreshPresetList()
+{
+    auto& presets = audioProcessor.getPresetBank();
+    
+    mPreset.clear(juce::dontSendNotification);
+    
+    for(int index = 0; index < presets.getNumPresets(); index++) {
+        mPreset.addItem(presets.getName(index), index + 1);
+    }
+    
+    mPreset.setSelectedItemIndex(audioProcessor.getCurrentProgram(), juce::dontSendNotification);
+}
+
+void OfChorusAudioProcessorEditor::savePreset()
+{
+    // Asking for a name without blocking the message thread
+    auto* window = new juce::AlertWindow("Save Preset", "Name of the new user preset", juce::AlertWindow::NoIcon, this);
+    window->addTextEditor("name", "User Preset");
+    window->addButton("Save", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("Cancel", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+    
+    juce::Component::SafePointer<OfChorusAudioProcessorEditor> editor(this);
+    
+    window->enterModalState(true, juce::ModalCallbackFunction::create([editor, window] (int result) {
+        const juce::String name = window->getTextEditorContents("name").trim();
+        
+        if(result != 1 || name.isEmpty() || editor == nullptr) {
+            return;
+        }
+        
+        if(editor->audioProcessor.saveUserPreset(name)) {
+            editor->refreshPresetList();
+        }
+    }), true);
+}
+
+#if OF_CHORUS_PROFILING
+void OfChorusAudioProcessorEditor::updateCpuLoad()
+{
+    const auto stats = audioProcessor.getProfiler().getStats();
+    
+    if(stats.numBlocks == 0) {
+        mCpuLoad.setText("CPU  no blocks yet", juce::dontSendNotification);
+        return;
+    }
+    
+    mCpuLoad.setText("CPU  min " + juce::String(stats.minLoad, 1)
+                     + "%  med " + juce::String(stats.medianLoad, 0)
+                     + "%  p99 " + juce::String(stats.p99Load, 0)
+                     + "%  max " + juce::String(stats.maxLoad, 1) + "%", juce::dontSendNotification);
+}
+
+void OfChorusAudioProcessorEditor::exportProfile()
+{
+    mProfileChooser = std::make_unique<juce::FileChooser>("Export CPU profile",
+                                                          juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("OfChorusProfile.csv"),
+                                                          "*.csv");
+    
+    const int flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles | juce::FileBrowserComponent::warnAboutOverwriting;
+    
+    // The chooser belongs to the editor, so the callback never outlives it
+    mProfileChooser->launchAsync(flags, [this] (const juce::FileChooser& chooser) {
+        const juce::File file = chooser.getResult();
+        
+        if(file != juce::File()) {
+            file.replaceWithText(audioProcessor.getProfiler().toCSV());
+        }
+    });
+}
+#endif
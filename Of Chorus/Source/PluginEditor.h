@@ -1,41 +1,105 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-
-//==============================================================================
-/**
-*/
-class OfChorusAudioProcessorEditor  : public juce::AudioProcessorEditor
-{
-public:
-    OfChorusAudioProcessorEditor (OfChorusAudioProcessor&);
-    ~OfChorusAudioProcessorEditor() override;
-
-    //==============================================================================
-    void paint (juce::Graphics&) override;
-    void resized() override;
-
-private:
-    // This reference is provided as a quick way for your editor to
-    // access the processor object that created it.
-    OfChorusAudioProcessor& audioProcessor;
-    
-    juce::Slider mDryWetSlider;
-    juce::Slider mDepthSlider;
-    juce::Slider mRateSlider;
-    juce::Slider mPhaseOffsetSlider;
-    juce::Slider mFeedbackSlider;
-    
-    juce::ComboBox mType;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfChorusAudioProcessorEditor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "TelemetryViews.h"
+#include "OfChorusLookAndFeel.h"
+#include "ParameterSync.h"
+
+//==============================================================================
+/**
+*/
+class OfChorusAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                      private juce::Timer
+{
+public:
+    OfChorusAudioProcessorEditor (OfChorusAudioProcessor&);
+    ~OfChorusAudioProcessorEditor() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+    /** The scope, meters and parameter sync all run on one timer at this rate. */
+    static constexpr int displayRefreshHz = 30;
+    
+    /** The layout is designed at this size and scaled uniformly from it. */
+    static constexpr int baseWidth = 400;
+    static constexpr int baseHeight = 400;
+    
+   #if OF_CHORUS_PROFILING
+    /** How often the CPU load readout changes. */
+    static constexpr int profileRefreshHz = 4;
+   #endif
+
+private:
+    void timerCallback() override;
+    
+    void updateControl (int index, float value);
+    
+    void refreshPresetList();
+    void savePreset();
+    
+   #if OF_CHORUS_PROFILING
+    void updateCpuLoad();
+    void exportProfile();
+   #endif
+    
+    void renderBackground (float pixelScale);
+    float getLayoutScale() const;
+    juce::Rectangle<int> scaled (juce::Rectangle<int> bounds) const;
+    
+    // This reference is provided as a quick way for your editor to
+    // access the processor object that created it.
+    OfChorusAudioProcessor& audioProcessor;
+    
+    ParameterSync mParameterSync;
+    
+    // Declared before the controls so it outlives them
+    OfChorusLookAndFeel mLookAndFeel;
+    
+    // Labels and dividers, rendered once per size and display scale
+    juce::Image mBackground;
+    float mBackgroundPixelScale;
+    
+    juce::Slider mDryWetSlider;
+    juce::Slider mDepthSlider;
+    juce::Slider mRateSlider;
+    juce::Slider mPhaseOffsetSlider;
+    juce::Slider mFeedbackSlider;
+    juce::Slider mVoicesSlider;
+    
+    juce::ComboBox mType;
+    juce::ComboBox mInterpolation;
+    
+    juce::Slider mEnvelopeAttackSlider;
+    juce::Slider mEnvelopeReleaseSlider;
+    juce::Slider mEnvelopeDepthSlider;
+    juce::Slider mEnvelopeRateSlider;
+    juce::Slider mEnvelopeMixSlider;
+    juce::ComboBox mEnvelopeDetector;
+    
+    juce::ComboBox mPreset;
+    juce::TextButton mSavePreset;
+    
+    LFOScope mScope;
+    LevelMeter mMeter;
+    
+   #if OF_CHORUS_PROFILING
+    juce::Label mCpuLoad;
+    juce::TextButton mResetProfile;
+    juce::TextButton mExportProfile;
+    std::unique_ptr<juce::FileChooser> mProfileChooser;
+    int mProfileTicks;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfChorusAudioProcessorEditor)
+};
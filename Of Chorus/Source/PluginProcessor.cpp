@@ -1,338 +1,456 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-OfChorusAudioProcessor::OfChorusAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       )
-#endif
-{
-    addParameter(mDryWetParameter = new juce::AudioParameterFloat("drywet", "Dry/Wet", 0.0, 1.0, 0.5));
-    addParameter(mDepthParameter = new juce::AudioParameterFloat("depth", "Depth", 0.0, 1.0, 0.5));
-    addParameter(mRateParameter = new juce::AudioParameterFloat("rate", "Rate", 0.1f, 20.0f, 10.0f));
-    addParameter(mPhaseOffsetParameter = new juce::AudioParameterFloat("phaseoffset", "Phase Offset", 0.0f, 1.0f, 0.0f));
-    addParameter(mFeedbackParameter = new juce::AudioParameterFloat("feedback", "Feedback", 0.0, 0.98, 0.5));
-    addParameter(mTypeParameter = new juce::AudioParameterInt ("type", "Type", 0, 1, 0));
-    
-    mLFOPhase = 0;
-    
-    mCircularBufferLeft = nullptr;
-    mCircularBufferRight = nullptr;
-    
-    mCircularBufferWriteHead = 0;
-    mCircularBufferLength = 0;
-    
-    mFeedbackLeft = 0;
-    mFeedbackRight = 0;
-}
-
-OfChorusAudioProcessor::~OfChorusAudioProcessor()
-{
-    if(mCircularBufferLeft != nullptr) {
-        delete [] mCircularBufferLeft;
-        mCircularBufferLeft = nullptr;
-    }
-    if(mCircularBufferRight != nullptr) {
-        delete [] mCircularBufferRight;
-        mCircularBufferRight = nullptr;
-    }
-}
-
-//==============================================================================
-const juce::String OfChorusAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool OfChorusAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool OfChorusAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool OfChorusAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double OfChorusAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int OfChorusAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int OfChorusAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void OfChorusAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String OfChorusAudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void OfChorusAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void OfChorusAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    mLFOPhase = 0;
-    
-    mCircularBufferLength = sampleRate * MAX_DELAY_TIME;
-    
-    if(mCircularBufferLeft == nullptr) {
-        mCircularBufferLeft = new float[mCircularBufferLength];
-    }
-    
-    juce::zeromem(mCircularBufferLeft, mCircularBufferLength * sizeof(float));
-    
-    if(mCircularBufferRight == nullptr) {
-        mCircularBufferRight = new float[mCircularBufferLength];
-    }
-    
-    juce::zeromem(mCircularBufferRight, mCircularBufferLength * sizeof(float));
-
-    mCircularBufferWriteHead = 0;
-}
-
-void OfChorusAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool OfChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-void OfChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i) {
-        buffer.clear(i, 0, buffer.getNumSamples());
-    }
-
-    float* leftChannel = buffer.getWritePointer(0);
-    float* rightChannel = buffer.getWritePointer(1);
-    
-    for(int i = 0; i < buffer.getNumSamples(); i++) {
-        // Writing to buffer and adding feedback
-        mCircularBufferLeft[mCircularBufferWriteHead] = leftChannel[i] + mFeedbackLeft;
-        mCircularBufferRight[mCircularBufferWriteHead] = rightChannel[i] + mFeedbackRight;
-        
-        // Calculating delay for left channel with LFO
-        float lfoOutLeft = sin(2 * M_PI * mLFOPhase);
-        lfoOutLeft *= *mDepthParameter;
-        
-        // Calculating delay for right channel with LFO + offset
-        float lfoPhaseRight = mLFOPhase + *mPhaseOffsetParameter;
-        
-        if(lfoPhaseRight > 1) {
-            lfoPhaseRight -= 1;
-        }
-        
-        float lfoOutRight = sin(2 * M_PI * lfoPhaseRight);
-        lfoOutRight *= *mDepthParameter;
-        
-        float lfoOutMappedLeft = 0;
-        float lfoOutMappedRight = 0;
-        
-        // Updating LFO phase
-        mLFOPhase += *mRateParameter / getSampleRate();
-        
-        // Chorus effect
-        if (*mTypeParameter == 0) {
-            lfoOutMappedLeft = juce::jmap<float>(lfoOutLeft, -1.f, 1.f, 0.005f, 0.03f);
-            lfoOutMappedRight = juce::jmap<float>(lfoOutRight, -1.f, 1.f, 0.005f, 0.03f);
-        }
-        // Flanger effect
-        else {
-            lfoOutMappedLeft = juce::jmap<float>(lfoOutLeft, -1.f, 1.f, 0.001f, 0.005f);
-            lfoOutMappedRight = juce::jmap<float>(lfoOutRight, -1.f, 1.f, 0.001f, 0.005f);
-        }
-        
-        float delayTimeSamplesLeft = getSampleRate() * lfoOutMappedLeft;
-        float delayTimeSamplesRight = getSampleRate() * lfoOutMappedRight;
-        
-        if(mLFOPhase > 1) {
-            mLFOPhase -= 1;
-        }
-        
-        // Calculating read head for left channel delay sample
-        float delayReadHeadLeft = mCircularBufferWriteHead - delayTimeSamplesLeft;
-        
-        if(delayReadHeadLeft < 0) {
-            delayReadHeadLeft += mCircularBufferLength;
-        }
-        
-        int readHeadLeft_x = (int) delayReadHeadLeft;
-        int readHeadLeft_x1 = readHeadLeft_x + 1;
-        float readHeadFloatLeft = delayReadHeadLeft - readHeadLeft_x;
-        
-        if(readHeadLeft_x1 >= mCircularBufferLength) {
-            readHeadLeft_x1 -= mCircularBufferLength;
-        }
-        
-        // Calculating read head for right channel delay sample
-        float delayReadHeadRight = mCircularBufferWriteHead - delayTimeSamplesRight;
-        
-        if(delayReadHeadRight < 0) {
-            delayReadHeadRight += mCircularBufferLength;
-        }
-        
-        int readHeadRight_x = (int) delayReadHeadRight;
-        int readHeadRight_x1 = readHeadRight_x + 1;
-        float readHeadFloatRight = delayReadHeadRight - readHeadRight_x;
-        
-        if(readHeadRight_x1 >= mCircularBufferLength) {
-            readHeadRight_x1 -= mCircularBufferLength;
-        }
-        
-        // Interpolating delay samples from current read head positions for both channels
-        float delay_sample_left = lin_interp(mCircularBufferLeft[readHeadLeft_x], mCircularBufferLeft[readHeadLeft_x1], readHeadFloatLeft);
-        float delay_sample_right = lin_interp(mCircularBufferRight[readHeadRight_x], mCircularBufferRight[readHeadRight_x1], readHeadFloatRight);
-        
-        // Calculating feedback samples
-        mFeedbackLeft = delay_sample_left * *mFeedbackParameter;
-        mFeedbackRight = delay_sample_right * *mFeedbackParameter;
-        
-        // Updating buffer write head
-        mCircularBufferWriteHead++;
-
-        if(mCircularBufferWriteHead >= mCircularBufferLength) {
-            mCircularBufferWriteHead = 0;
-        }
-        
-        // Mixing sample between dry and wet signal
-        float dryAmount = 1 - *mDryWetParameter;
-        float wetAmount = *mDryWetParameter;
-        
-        buffer.setSample(0, i, buffer.getSample(0, i) * dryAmount + delay_sample_left * wetAmount);
-        buffer.setSample(1, i, buffer.getSample(1, i) * dryAmount + delay_sample_right * wetAmount);
-    }
-}
-
-//==============================================================================
-bool OfChorusAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* OfChorusAudioProcessor::createEditor()
-{
-    return new OfChorusAudioProcessorEditor (*this);
-}
-
-//==============================================================================
-void OfChorusAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    std::unique_ptr<juce::XmlElement> xml(new juce::XmlElement("FlangerChorus"));
-    
-    xml->setAttribute("DryWet", *mDryWetParameter);
-    xml->setAttribute("Depth", *mDepthParameter);
-    xml->setAttribute("Rate", *mRateParameter);
-    xml->setAttribute("PhaseOffset", *mPhaseOffsetParameter);
-    xml->setAttribute("Feedback", *mFeedbackParameter);
-    xml->setAttribute("Type", *mTypeParameter);
-    
-    copyXmlToBinary(*xml, destData);
-}
-
-void OfChorusAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
-    
-    if(xml.get() != nullptr && xml->hasTagName("FlangerChorus")) {
-        *mDryWetParameter = xml->getDoubleAttribute("DryWet");
-        *mDepthParameter = xml->getDoubleAttribute("Depth");
-        *mRateParameter = xml->getDoubleAttribute("Rate");
-        *mPhaseOffsetParameter = xml->getDoubleAttribute("PhaseOffset");
-        *mFeedbackParameter = xml->getDoubleAttribute("Feedback");
-        *mTypeParameter = xml->getIntAttribute("Type");
-    }
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new OfChorusAudioProcessor();
-}
-
-float OfChorusAudioProcessor::lin_interp(float sample_x, float sample_x1, float inPhase)
-{
-    return (1 - inPhase) * sample_x + inPhase * sample_x1;
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+#include "RealtimeGuard.h"
+
+//==============================================================================
+OfChorusAudioProcessor::OfChorusAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       )
+#endif
+{
+    addParameter(mDryWetParameter = new juce::AudioParameterFloat("drywet", "Dry/Wet", 0.0, 1.0, 0.5));
+    addParameter(mDepthParameter = new juce::AudioParameterFloat("depth", "Depth", 0.0, 1.0, 0.5));
+    addParameter(mRateParameter = new juce::AudioParameterFloat("rate", "Rate", ChorusKernel::minRate, ChorusKernel::maxRate, 10.0f));
+    addParameter(mPhaseOffsetParameter = new juce::AudioParameterFloat("phaseoffset", "Phase Offset", 0.0f, 1.0f, 0.0f));
+    addParameter(mFeedbackParameter = new juce::AudioParameterFloat("feedback", "Feedback", 0.0, 0.98, 0.5));
+    addParameter(mTypeParameter = new juce::AudioParameterInt ("type", "Type", 0, numEffectTypes - 1, 0));
+    addParameter(mVoicesParameter = new juce::AudioParameterInt ("voices", "Voices", 1, ChorusKernel::maxVoices, 1));
+    addParameter(mInterpolationParameter = new juce::AudioParameterInt ("interpolation", "Interpolation", 0, numInterpolationTypes - 1, 0));
+    addParameter(mEnvelopeAttackParameter = new juce::AudioParameterFloat("envattack", "Envelope Attack", 0.1f, 100.0f, 10.0f));
+    addParameter(mEnvelopeReleaseParameter = new juce::AudioParameterFloat("envrelease", "Envelope Release", 10.0f, 1000.0f, 200.0f));
+    addParameter(mEnvelopeDetectorParameter = new juce::AudioParameterInt ("envdetector", "Envelope Detector", 0, numEnvelopeDetectors - 1, 0));
+    addParameter(mEnvelopeDepthParameter = new juce::AudioParameterFloat("envdepth", "Envelope to Depth", -1.0f, 1.0f, 0.0f));
+    addParameter(mEnvelopeRateParameter = new juce::AudioParameterFloat("envrate", "Envelope to Rate", -1.0f, 1.0f, 0.0f));
+    addParameter(mEnvelopeMixParameter = new juce::AudioParameterFloat("envmix", "Envelope to Mix", -1.0f, 1.0f, 0.0f));
+    
+    mCurrentProgram = 0;
+    mPresetChanged = false;
+    
+    juce::FloatVectorOperations::clear(mEnvelopeLevels, juce::numElementsInArray(mEnvelopeLevels));
+    
+    mTelemetryEnabled = false;
+    mTelemetrySamples = 0;
+    
+    for(int channel = 0; channel < TelemetryFrame::maxMeterChannels; channel++) {
+        mTelemetryPeak[channel] = 0;
+        mTelemetrySquares[channel] = 0;
+    }
+}
+
+OfChorusAudioProcessor::~OfChorusAudioProcessor()
+{
+}
+
+//==============================================================================
+const juce::String OfChorusAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool OfChorusAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool OfChorusAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool OfChorusAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double OfChorusAudioProcessor::getTailLengthSeconds() const
+{
+    // The feedback loop keeps ringing after the input stops, how long depends on the current settings
+    return ChorusKernel::getTailLengthSeconds(getParameterSnapshot());
+}
+
+int OfChorusAudioProcessor::getNumPrograms()
+{
+    // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // so this should be at least 1
+    return juce::jmax(1, mPresets->getNumPresets());
+}
+
+int OfChorusAudioProcessor::getCurrentProgram()
+{
+    return mCurrentProgram;
+}
+
+void OfChorusAudioProcessor::setCurrentProgram (int index)
+{
+    float fields[PluginState::maxFields];
+    const int numFields = mPresets->getFields(index, fields, getParameters().size());
+    
+    if(numFields < 0) {
+        return;
+    }
+    
+    mCurrentProgram = index;
+    
+    // Flagging the switch before the first parameter moves, so the audio thread glides to all of them
+    mPresetChanged = true;
+    setParameterFields(fields, numFields);
+}
+
+const juce::String OfChorusAudioProcessor::getProgramName (int index)
+{
+    return mPresets->getName(index);
+}
+
+void OfChorusAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    juce::ignoreUnused (index, newName);
+}
+
+//==============================================================================
+void OfChorusAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    juce::ignoreUnused (samplesPerBlock);
+    
+    // The kernel sizes its delay line from the longest delay it can read at this sample rate
+    mKernel.prepare(sampleRate, juce::jmin(getTotalNumInputChannels(), ChorusKernel::maxChannels));
+    mCrossfade.prepare(sampleRate);
+    mEnvelope.prepare(sampleRate);
+    
+   #if OF_CHORUS_PROFILING
+    // Blocks at the old sample rate and block size would skew the new statistics
+    mProfiler.reset();
+   #endif
+}
+
+void OfChorusAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool OfChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // The kernel handles any channel count up to ChorusKernel::maxChannels, so mono,
+    // stereo, surround and ambisonic layouts are all fine as long as input matches output.
+    const auto& mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput.isDisabled() || mainOutput.size() > ChorusKernel::maxChannels)
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void OfChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processBlockInternal(buffer);
+}
+
+void OfChorusAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processBlockInternal(buffer);
+}
+
+bool OfChorusAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void OfChorusAudioProcessor::processBlockInternal (juce::AudioBuffer<SampleType>& buffer)
+{
+    // In checked builds, anything below that allocates, locks or blocks is reported
+    OF_CHORUS_REALTIME_SCOPE
+    
+   #if OF_CHORUS_PROFILING
+    const BlockProfiler::ScopedBlock profile(mProfiler, buffer.getNumSamples(), getSampleRate());
+   #endif
+    
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    // This is here to avoid people getting screaming feedback
+    // when they first compile a plugin, but obviously you don't need to keep
+    // this code if your algorithm always overwrites all the output channels.
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i) {
+        buffer.clear(i, 0, buffer.getNumSamples());
+    }
+
+    const int numChannels = juce::jmin(totalNumInputChannels, buffer.getNumChannels(), ChorusKernel::maxChannels);
+    
+    if(mPresetChanged.exchange(false)) {
+        mCrossfade.start();
+    }
+    
+    const auto parameters = mCrossfade.process(getParameterSnapshot(), buffer.getNumSamples());
+    
+    const bool telemetryEnabled = mTelemetryEnabled.load(std::memory_order_relaxed);
+    
+    // The kernel follows the envelope at the follower's segment boundaries, longer blocks go through in parts.
+    // With the telemetry on, a part also ends wherever a frame is due, so the frame reads the LFO where it was taken.
+    for(int startSample = 0; startSample < buffer.getNumSamples(); ) {
+        int numSamples = juce::jmin(envelopeBlockSize, buffer.getNumSamples() - startSample);
+        
+        if(telemetryEnabled) {
+            numSamples = juce::jmin(numSamples, TelemetryFifo::frameInterval - mTelemetrySamples);
+        }
+        
+        int firstBoundary = 0;
+        const float* levels = followEnvelope(buffer, numChannels, startSample, numSamples, firstBoundary);
+        
+        SampleType* channels[ChorusKernel::maxChannels];
+        
+        for(int channel = 0; channel < numChannels; channel++) {
+            channels[channel] = buffer.getWritePointer(channel, startSample);
+        }
+        
+        mKernel.process(channels, numChannels, numSamples, parameters, levels, firstBoundary);
+        
+        if(telemetryEnabled) {
+            updateTelemetry(buffer, numChannels, startSample, numSamples);
+        }
+        
+        startSample += numSamples;
+    }
+}
+
+template <typename SampleType>
+void OfChorusAudioProcessor::updateTelemetry (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples)
+{
+    const int numMeterChannels = juce::jmin(numChannels, TelemetryFrame::maxMeterChannels);
+    
+    // Accumulating the output levels of every channel
+    for(int channel = 0; channel < numMeterChannels; channel++) {
+        const double rms = buffer.getRMSLevel(channel, startSample, numSamples);
+        
+        mTelemetryPeak[channel] = juce::jmax(mTelemetryPeak[channel], (float) buffer.getMagnitude(channel, startSample, numSamples));
+        mTelemetrySquares[channel] += rms * rms * numSamples;
+    }
+    
+    mTelemetrySamples += numSamples;
+    
+    if(mTelemetrySamples < TelemetryFifo::frameInterval) {
+        return;
+    }
+    
+    // Without a channel to meter nothing is shown, but the count still starts over for the next frame
+    if(numMeterChannels > 0) {
+        pushTelemetryFrame(numMeterChannels);
+    }
+    
+    for(int channel = 0; channel < TelemetryFrame::maxMeterChannels; channel++) {
+        mTelemetryPeak[channel] = 0;
+        mTelemetrySquares[channel] = 0;
+    }
+    
+    mTelemetrySamples = 0;
+}
+
+void OfChorusAudioProcessor::pushTelemetryFrame (int numMeterChannels)
+{
+    TelemetryFrame frame;
+    frame.lfo = mKernel.getLFOValue();
+    frame.delayMs = (float) (mKernel.getDelayTimeSamples() * 1000.0 / getSampleRate());
+    
+    frame.numChannels = numMeterChannels;
+    
+    for(int channel = 0; channel < numMeterChannels; channel++) {
+        frame.peak[channel] = mTelemetryPeak[channel];
+        frame.rms[channel] = (float) std::sqrt(mTelemetrySquares[channel] / mTelemetrySamples);
+    }
+    
+    // A full FIFO means the editor is behind, the frame is simply dropped
+    mTelemetry.push(frame);
+}
+
+template <typename SampleType>
+const float* OfChorusAudioProcessor::followEnvelope (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples, int& firstBoundary)
+{
+    // With every amount at zero the follower costs nothing, and starts from silence when it is turned on
+    if(juce::exactlyEqual(mEnvelopeDepthParameter->get(), 0.0f) && juce::exactlyEqual(mEnvelopeRateParameter->get(), 0.0f)
+       && juce::exactlyEqual(mEnvelopeMixParameter->get(), 0.0f)) {
+        mEnvelope.reset();
+        return nullptr;
+    }
+    
+    mEnvelope.setAttackRelease(*mEnvelopeAttackParameter, *mEnvelopeReleaseParameter);
+    mEnvelope.setDetector((EnvelopeDetector) mEnvelopeDetectorParameter->get());
+    
+    const SampleType* channels[ChorusKernel::maxChannels];
+    
+    for(int channel = 0; channel < numChannels; channel++) {
+        channels[channel] = buffer.getReadPointer(channel, startSample);
+    }
+    
+    // Following the input, before the kernel overwrites it
+    firstBoundary = mEnvelope.process(channels, numChannels, numSamples, mEnvelopeLevels);
+    return mEnvelopeLevels;
+}
+
+ChorusKernel::Parameters OfChorusAudioProcessor::getParameterSnapshot() const
+{
+    // Reading every parameter once per block, the kernel ramps towards these values
+    ChorusKernel::Parameters parameters;
+    parameters.dryWet = *mDryWetParameter;
+    parameters.depth = *mDepthParameter;
+    parameters.rate = *mRateParameter;
+    parameters.phaseOffset = *mPhaseOffsetParameter;
+    parameters.feedback = *mFeedbackParameter;
+    parameters.type = *mTypeParameter;
+    parameters.voices = *mVoicesParameter;
+    parameters.interpolation = *mInterpolationParameter;
+    
+    // The kernel moves depth, rate and mix with the input level by these amounts
+    parameters.envelopeDepth = *mEnvelopeDepthParameter;
+    parameters.envelopeRate = *mEnvelopeRateParameter;
+    parameters.envelopeMix = *mEnvelopeMixParameter;
+    
+    // Fixing what the type fixes here, so a crossfade to or from vibrato still fades its mix
+    return ChorusKernel::applyEffectType(parameters);
+}
+
+//==============================================================================
+bool OfChorusAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* OfChorusAudioProcessor::createEditor()
+{
+    return new OfChorusAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+void OfChorusAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // Saving every parameter's plain value in the order they were added
+    const auto& parameters = getParameters();
+    float fields[PluginState::maxFields];
+    
+    for(int i = 0; i < parameters.size(); i++) {
+        auto* parameter = static_cast<juce::RangedAudioParameter*>(parameters.getUnchecked(i));
+        fields[i] = parameter->convertFrom0to1(parameter->getValue());
+    }
+    
+    PluginState::write(fields, parameters.size(), destData);
+}
+
+void OfChorusAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    if(! PluginState::isBinaryState(data, sizeInBytes)) {
+        setLegacyStateInformation(data, sizeInBytes);
+        return;
+    }
+    
+    float fields[PluginState::maxFields];
+    const int numFields = PluginState::read(data, sizeInBytes, fields, getParameters().size());
+    
+    if(numFields >= 0) {
+        setParameterFields(fields, numFields);
+    }
+}
+
+void OfChorusAudioProcessor::setParameterFields (const float* fields, int numFields)
+{
+    const auto& parameters = getParameters();
+    
+    // Parameters added after the state was saved fall back to their defaults
+    for(int i = 0; i < parameters.size(); i++) {
+        auto* parameter = static_cast<juce::RangedAudioParameter*>(parameters.getUnchecked(i));
+        const float value = i < numFields ? parameter->convertTo0to1(fields[i]) : parameter->getDefaultValue();
+        
+        parameter->setValueNotifyingHost(value);
+    }
+}
+
+bool OfChorusAudioProcessor::saveUserPreset (const juce::String& name)
+{
+    juce::MemoryBlock state;
+    getStateInformation(state);
+    
+    if(! mPresets->addUserPreset(name, state)) {
+        return false;
+    }
+    
+    // The new preset is always the last one
+    mCurrentProgram = mPresets->getNumPresets() - 1;
+    updateHostDisplay();
+    
+    return true;
+}
+
+void OfChorusAudioProcessor::setLegacyStateInformation (const void* data, int sizeInBytes)
+{
+    // States saved before the binary format were XML
+    std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
+    
+    if(xml.get() == nullptr || ! xml->hasTagName("FlangerChorus")) {
+        return;
+    }
+    
+    // The attributes of the first parameters, in the order they are added
+    static const char* const attributeNames[] = { "DryWet", "Depth", "Rate", "PhaseOffset", "Feedback", "Type", "Voices", "Interpolation" };
+    
+    const auto& parameters = getParameters();
+    
+    // Like setParameterFields, whatever the state doesn't have falls back to its default
+    for(int i = 0; i < parameters.size(); i++) {
+        auto* parameter = static_cast<juce::RangedAudioParameter*>(parameters.getUnchecked(i));
+        const bool saved = i < juce::numElementsInArray(attributeNames) && xml->hasAttribute(attributeNames[i]);
+        const float value = saved ? parameter->convertTo0to1((float) xml->getDoubleAttribute(attributeNames[i])) : parameter->getDefaultValue();
+        
+        parameter->setValueNotifyingHost(value);
+    }
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new OfChorusAudioProcessor();
+}
@@ -1,86 +1,144 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-
-#define MAX_DELAY_TIME 2
-
-//==============================================================================
-/**
-*/
-class OfChorusAudioProcessor  : public juce::AudioProcessor
-                            #if JucePlugin_Enable_ARA
-                             , public juce::AudioProcessorARAExtension
-                            #endif
-{
-public:
-    //==============================================================================
-    OfChorusAudioProcessor();
-    ~OfChorusAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-   #ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
-
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-    
-    float lin_interp(float sample_x, float sample_x1, float inPhase);
-
-
-private:
-    float mLFOPhase;
-    
-    juce::AudioParameterFloat* mDryWetParameter;
-    juce::AudioParameterFloat* mDepthParameter;
-    juce::AudioParameterFloat* mRateParameter;
-    juce::AudioParameterFloat* mPhaseOffsetParameter;
-    juce::AudioParameterFloat* mFeedbackParameter;
-    
-    juce::AudioParameterInt* mTypeParameter;
-    
-    float mFeedbackLeft;
-    float mFeedbackRight;
-    
-    int mCircularBufferWriteHead;
-    int mCircularBufferLength;
-    
-    float* mCircularBufferLeft;
-    float* mCircularBufferRight;
-    
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfChorusAudioProcessor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BlockProfiler.h"
+#include "ChorusKernel.h"
+#include "EnvelopeFollower.h"
+#include "ParameterCrossfade.h"
+#include "PluginState.h"
+#include "PresetBank.h"
+#include "TelemetryFifo.h"
+
+//==============================================================================
+/**
+*/
+class OfChorusAudioProcessor  : public juce::AudioProcessor
+                            #if JucePlugin_Enable_ARA
+                             , public juce::AudioProcessorARAExtension
+                            #endif
+{
+public:
+    //==============================================================================
+    OfChorusAudioProcessor();
+    ~OfChorusAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+   #ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+   #endif
+
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    //==============================================================================
+    /** Adds the current parameters to the shared bank as a user preset and selects it. */
+    bool saveUserPreset (const juce::String& name);
+    PresetBank& getPresetBank() { return *mPresets; }
+    
+    //==============================================================================
+    /** Readings for the editor's scope and meters, only filled while enabled. */
+    TelemetryFifo& getTelemetry() { return mTelemetry; }
+    void setTelemetryEnabled(bool enabled) { mTelemetryEnabled = enabled; }
+    
+   #if OF_CHORUS_PROFILING
+    /** How much of each block's deadline processBlock used. */
+    BlockProfiler& getProfiler() { return mProfiler; }
+   #endif
+
+
+private:
+    template <typename SampleType>
+    void processBlockInternal (juce::AudioBuffer<SampleType>& buffer);
+    
+    template <typename SampleType>
+    void updateTelemetry (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples);
+    void pushTelemetryFrame (int numMeterChannels);
+    
+    /** The follower's levels for numSamples of the buffer from startSample, or nullptr while no amount uses them. */
+    template <typename SampleType>
+    const float* followEnvelope (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples, int& firstBoundary);
+    
+    ChorusKernel::Parameters getParameterSnapshot() const;
+    
+    void setLegacyStateInformation (const void* data, int sizeInBytes);
+    void setParameterFields (const float* fields, int numFields);
+    
+    juce::AudioParameterFloat* mDryWetParameter;
+    juce::AudioParameterFloat* mDepthParameter;
+    juce::AudioParameterFloat* mRateParameter;
+    juce::AudioParameterFloat* mPhaseOffsetParameter;
+    juce::AudioParameterFloat* mFeedbackParameter;
+    
+    juce::AudioParameterInt* mTypeParameter;
+    juce::AudioParameterInt* mVoicesParameter;
+    juce::AudioParameterInt* mInterpolationParameter;
+    
+    juce::AudioParameterFloat* mEnvelopeAttackParameter;
+    juce::AudioParameterFloat* mEnvelopeReleaseParameter;
+    juce::AudioParameterInt* mEnvelopeDetectorParameter;
+    juce::AudioParameterFloat* mEnvelopeDepthParameter;
+    juce::AudioParameterFloat* mEnvelopeRateParameter;
+    juce::AudioParameterFloat* mEnvelopeMixParameter;
+    
+    ChorusKernel mKernel;
+    
+    // The follower's levels are handed to the kernel for up to envelopeBlockSize samples at a time
+    static constexpr int envelopeBlockSize = 4096;
+    EnvelopeFollower mEnvelope;
+    float mEnvelopeLevels[envelopeBlockSize / EnvelopeFollower::segmentSize + 3];
+    
+    // Presets are recalled on the message thread and glided to on the audio thread
+    juce::SharedResourcePointer<PresetBank> mPresets;
+    int mCurrentProgram;
+    std::atomic<bool> mPresetChanged;
+    ParameterCrossfade mCrossfade;
+    
+    // Levels are accumulated over TelemetryFifo::frameInterval samples before a frame is pushed
+    TelemetryFifo mTelemetry;
+    std::atomic<bool> mTelemetryEnabled;
+    float mTelemetryPeak[TelemetryFrame::maxMeterChannels];
+    double mTelemetrySquares[TelemetryFrame::maxMeterChannels];
+    int mTelemetrySamples;
+    
+   #if OF_CHORUS_PROFILING
+    BlockProfiler mProfiler;
+   #endif
+    
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfChorusAudioProcessor)
+};
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    PluginState.cpp
+
+  ==============================================================================
+*/
+
+#include "PluginState.h"
+
+namespace
+{
+    template <typename IntegerType>
+    void writeLittleEndian(juce::uint8* destination, IntegerType value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(destination, &value, sizeof(value));
+    }
+}
+
+//==============================================================================
+void PluginState::write(const float* fields, int numFields, juce::MemoryBlock& destData)
+{
+    jassert(numFields <= maxFields);
+    
+    destData.setSize(getStateSize(numFields));
+    auto* bytes = static_cast<juce::uint8*>(destData.getData());
+    
+    // Writing the fields first, the checksum covers them
+    for(int i = 0; i < numFields; i++) {
+        juce::uint32 bits;
+        std::memcpy(&bits, &fields[i], sizeof(bits));
+        writeLittleEndian(bytes + headerSize + i * 4, bits);
+    }
+    
+    writeLittleEndian(bytes, (juce::uint32) magic);
+    writeLittleEndian(bytes + 4, (juce::uint16) currentVersion);
+    writeLittleEndian(bytes + 6, (juce::uint16) numFields);
+    writeLittleEndian(bytes + 8, getChecksum(bytes + headerSize, (size_t) numFields * 4));
+}
+
+int PluginState::read(const void* data, int sizeInBytes, float* fields, int maxNumFields)
+{
+    if(! isBinaryState(data, sizeInBytes)) {
+        return -1;
+    }
+    
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    const int version = juce::ByteOrder::littleEndianShort(bytes + 4);
+    const int numFields = juce::ByteOrder::littleEndianShort(bytes + 6);
+    
+    // Checking everything before a single field is taken
+    if(version > currentVersion || numFields > maxFields || (size_t) sizeInBytes < getStateSize(numFields)) {
+        return -1;
+    }
+    
+    if(juce::ByteOrder::littleEndianInt(bytes + 8) != getChecksum(bytes + headerSize, (size_t) numFields * 4)) {
+        return -1;
+    }
+    
+    for(int i = 0; i < juce::jmin(numFields, maxNumFields); i++) {
+        const juce::uint32 bits = juce::ByteOrder::littleEndianInt(bytes + headerSize + i * 4);
+        std::memcpy(&fields[i], &bits, sizeof(bits));
+    }
+    
+    return numFields;
+}
+
+bool PluginState::isBinaryState(const void* data, int sizeInBytes)
+{
+    return data != nullptr && sizeInBytes >= headerSize
+        && juce::ByteOrder::littleEndianInt(data) == magic;
+}
+
+juce::uint32 PluginState::getChecksum(const juce::uint8* bytes, size_t numBytes)
+{
+    juce::uint32 hash = 2166136261u;
+    
+    for(size_t i = 0; i < numBytes; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    
+    return hash;
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    PluginState.h
+
+    Compact binary format for the plugin's saved state. A fixed size header
+    is followed by one little endian float32 per parameter, in the order the
+    processor adds its parameters, so a save is a single small copy and a
+    load is a few bounds checks and a checksum instead of an XML parse.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Layout, every field little endian:
+
+        uint32  magic
+        uint16  version
+        uint16  numFields
+        uint32  checksum (FNV-1a over the fields)
+        float32 fields[numFields]
+
+    New parameters are appended as new fields without changing the version.
+    Readers take the fields they know and ignore the rest, and fields missing
+    from older states keep the parameter's default. The version only goes up
+    when an existing field changes meaning, and newer versions are rejected.
+*/
+class PluginState
+{
+public:
+    static constexpr juce::uint32 magic = 0x4f664368; // "OfCh"
+    static constexpr juce::uint16 currentVersion = 1;
+    static constexpr int headerSize = 12;
+
+    /** Upper bound on the fields a state may hold, so readers can use a fixed buffer. */
+    static constexpr int maxFields = 256;
+
+    static size_t getStateSize(int numFields) { return (size_t) (headerSize + numFields * 4); }
+
+    /** Replaces the contents of destData with a state holding the given fields. */
+    static void write(const float* fields, int numFields, juce::MemoryBlock& destData);
+
+    /**
+        Reads up to maxNumFields fields into fields and returns how many the
+        state held, or -1 if the data is not a valid binary state of a version
+        this build understands.
+    */
+    static int read(const void* data, int sizeInBytes, float* fields, int maxNumFields);
+
+    /** True if the data starts with this format's magic number. */
+    static bool isBinaryState(const void* data, int sizeInBytes);
+
+private:
+    static juce::uint32 getChecksum(const juce::uint8* bytes, size_t numBytes);
+};
@@ -0,0 +1,330 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+    /** Fields in the processor's parameter order: dry/wet, depth, rate, phase offset,
+        feedback, type, voices, interpolation. */
+    struct FactoryPreset
+    {
+        const char* name;
+        float fields[8];
+    };
+
+    const FactoryPreset factoryPresets[] = {
+        { "Init",               { 0.5f, 0.5f, 10.0f, 0.0f,  0.5f,  0.0f, 1.0f, 0.0f } },
+        { "Subtle Chorus",      { 0.3f, 0.3f, 0.8f,  0.25f, 0.1f,  0.0f, 2.0f, 1.0f } },
+        { "Wide Ensemble",      { 0.5f, 0.5f, 0.6f,  0.5f,  0.2f,  0.0f, 6.0f, 1.0f } },
+        { "Lush Eight Voices",  { 0.6f, 0.6f, 0.4f,  0.5f,  0.3f,  0.0f, 8.0f, 3.0f } },
+        { "Warble",             { 0.5f, 0.9f, 6.0f,  0.0f,  0.0f,  0.0f, 1.0f, 1.0f } },
+        { "Slow Flanger",       { 0.5f, 0.8f, 0.2f,  0.0f,  0.7f,  1.0f, 1.0f, 1.0f } },
+        { "Jet Flanger",        { 0.6f, 1.0f, 0.1f,  0.25f, 0.95f, 1.0f, 2.0f, 3.0f } },
+        { "Metallic Flanger",   { 0.5f, 0.4f, 5.0f,  0.0f,  0.9f,  1.0f, 1.0f, 2.0f } }
+    };
+
+    template <typename IntegerType>
+    void writeLittleEndian(juce::uint8* destination, IntegerType value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(destination, &value, sizeof(value));
+    }
+}
+
+//==============================================================================
+PresetBank::PresetBank()
+{
+    mBank = nullptr;
+    mNumReaders = 0;
+    
+    // Built up front, the factory bank reads straight from it
+    writeBank(getFactoryPresets(), mFactoryBank);
+    
+    open(getDefaultFile());
+}
+
+PresetBank::~PresetBank()
+{
+    delete mBank.exchange(nullptr);
+}
+
+PresetBank::ScopedReader::ScopedReader(const PresetBank& presetBank)
+    : mPresetBank(presetBank)
+{
+    // Counting in first, so a swap that happens after this waits for the bank loaded below
+    mPresetBank.mNumReaders.fetch_add(1);
+    mBank = mPresetBank.mBank.load();
+}
+
+PresetBank::ScopedReader::~ScopedReader()
+{
+    mPresetBank.mNumReaders.fetch_sub(1);
+}
+
+juce::File PresetBank::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("Of Chorus")
+        .getChildFile("Presets.ofchorusbank");
+}
+
+void PresetBank::open(const juce::File& file)
+{
+    // Mapping and checking the file before it is published, readers never see a bank half way there
+    auto bank = std::make_unique<Bank>();
+    
+    if(file.existsAsFile()) {
+        bank->mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+        
+        // A damaged file is left alone, the next saved preset replaces it
+        if(! isValidBank(bank->mappedFile->getData(), bank->mappedFile->getSize())) {
+            bank->mappedFile.reset();
+        }
+    }
+    
+    if(bank->mappedFile != nullptr) {
+        bank->setData(bank->mappedFile->getData(), bank->mappedFile->getSize());
+    }
+    else {
+        bank->setData(mFactoryBank.getData(), mFactoryBank.getSize());
+    }
+    
+    mFile = file;
+    publish(std::move(bank));
+}
+
+void PresetBank::publish(std::unique_ptr<Bank> bank)
+{
+    std::unique_ptr<Bank> oldBank(mBank.exchange(bank.release()));
+    
+    // A reader that counted itself in before the swap may still hold the old bank, the ones
+    // after it load the new one. Readers only copy a few bytes, so this never waits long
+    while(mNumReaders.load() > 0) {
+        juce::Thread::yield();
+    }
+}
+
+int PresetBank::getNumPresets() const
+{
+    const ScopedReader bank(*this);
+    return bank->numPresets;
+}
+
+juce::String PresetBank::getName(int index) const
+{
+    const ScopedReader bank(*this);
+    
+    const char* name;
+    int length;
+    
+    if(! bank->getName(index, name, length)) {
+        return {};
+    }
+    
+    return juce::String::fromUTF8(name, length);
+}
+
+bool PresetBank::isFactoryPreset(int index) const
+{
+    const ScopedReader bank(*this);
+    const juce::uint8* entry = bank->getEntry(index);
+    
+    return entry != nullptr && (juce::ByteOrder::littleEndianShort(entry + 6) & isFactoryFlag) != 0;
+}
+
+juce::Array<int> PresetBank::search(const juce::String& text) const
+{
+    const ScopedReader bank(*this);
+    juce::Array<int> found;
+    
+    for(int index = 0; index < bank->numPresets; index++) {
+        const char* name;
+        int length;
+        
+        if(bank->getName(index, name, length) && juce::String::fromUTF8(name, length).containsIgnoreCase(text)) {
+            found.add(index);
+        }
+    }
+    
+    return found;
+}
+
+int PresetBank::getFields(int index, float* fields, int maxNumFields) const
+{
+    const ScopedReader bank(*this);
+    const juce::uint8* entry = bank->getEntry(index);
+    
+    if(entry == nullptr) {
+        return -1;
+    }
+    
+    const size_t stateOffset = juce::ByteOrder::littleEndianInt(entry + 8);
+    const size_t stateSize = juce::ByteOrder::littleEndianInt(entry + 12);
+    
+    if(stateOffset > bank->size || stateSize > bank->size - stateOffset) {
+        return -1;
+    }
+    
+    return PluginState::read(bank->data + stateOffset, (int) stateSize, fields, maxNumFields);
+}
+
+bool PresetBank::addUserPreset(const juce::String& name, const juce::MemoryBlock& state)
+{
+    std::vector<Preset> presets;
+    
+    {
+        const ScopedReader bank(*this);
+        presets.reserve((size_t) bank->numPresets + 1);
+        
+        for(int index = 0; index < bank->numPresets; index++) {
+            const juce::uint8* entry = bank->getEntry(index);
+            const size_t stateOffset = juce::ByteOrder::littleEndianInt(entry + 8);
+            const size_t stateSize = juce::ByteOrder::littleEndianInt(entry + 12);
+            const char* presetName;
+            int length;
+            
+            if(! bank->getName(index, presetName, length) || stateOffset > bank->size || stateSize > bank->size - stateOffset) {
+                continue;
+            }
+            
+            presets.push_back({ juce::String::fromUTF8(presetName, length),
+                                juce::ByteOrder::littleEndianShort(entry + 6),
+                                juce::MemoryBlock(bank->data + stateOffset, stateSize) });
+        }
+    }
+    
+    presets.push_back({ name, 0, state });
+    
+    // The mapping has to go before the file can be replaced on every platform, the new bank is served from memory meanwhile
+    auto userBank = std::make_unique<Bank>();
+    writeBank(presets, userBank->memory);
+    userBank->setData(userBank->memory.getData(), userBank->memory.getSize());
+    
+    // Only this thread releases banks, so it stays valid until open() replaces it
+    const Bank& published = *userBank;
+    publish(std::move(userBank));
+    
+    const bool written = mFile.getParentDirectory().createDirectory().wasOk() && mFile.replaceWithData(published.data, published.size);
+    
+    open(mFile);
+    
+    return written;
+}
+
+void PresetBank::writeBank(const std::vector<Preset>& presets, juce::MemoryBlock& destData)
+{
+    // Sizing the whole file first, so it is written in one pass
+    size_t size = (size_t) headerSize + presets.size() * (size_t) entrySize;
+    
+    for(const auto& preset : presets) {
+        size += preset.name.getNumBytesAsUTF8() + preset.state.getSize();
+    }
+    
+    destData.setSize(size, true);
+    auto* bytes = static_cast<juce::uint8*>(destData.getData());
+    
+    writeLittleEndian(bytes, (juce::uint32) magic);
+    writeLittleEndian(bytes + 4, (juce::uint16) currentVersion);
+    writeLittleEndian(bytes + 8, (juce::uint32) presets.size());
+    
+    size_t offset = (size_t) headerSize + presets.size() * (size_t) entrySize;
+    
+    for(size_t index = 0; index < presets.size(); index++) {
+        const auto& preset = presets[index];
+        juce::uint8* entry = bytes + headerSize + index * entrySize;
+        
+        // Names longer than the index can describe are cut at a character boundary
+        juce::String name = preset.name;
+        
+        while(name.getNumBytesAsUTF8() > 0xffff) {
+            name = name.dropLastCharacters(1);
+        }
+        
+        const size_t nameLength = name.getNumBytesAsUTF8();
+        
+        writeLittleEndian(entry, (juce::uint32) offset);
+        writeLittleEndian(entry + 4, (juce::uint16) nameLength);
+        writeLittleEndian(entry + 6, preset.flags);
+        std::memcpy(bytes + offset, name.toRawUTF8(), nameLength);
+        offset += nameLength;
+        
+        writeLittleEndian(entry + 8, (juce::uint32) offset);
+        writeLittleEndian(entry + 12, (juce::uint32) preset.state.getSize());
+        std::memcpy(bytes + offset, preset.state.getData(), preset.state.getSize());
+        offset += preset.state.getSize();
+    }
+    
+    destData.setSize(offset);
+}
+
+std::vector<PresetBank::Preset> PresetBank::getFactoryPresets()
+{
+    std::vector<Preset> presets;
+    
+    for(const auto& factoryPreset : factoryPresets) {
+        Preset preset;
+        preset.name = factoryPreset.name;
+        preset.flags = isFactoryFlag;
+        PluginState::write(factoryPreset.fields, juce::numElementsInArray(factoryPreset.fields), preset.state);
+        
+        presets.push_back(std::move(preset));
+    }
+    
+    return presets;
+}
+
+bool PresetBank::isValidBank(const void* data, size_t size)
+{
+    if(data == nullptr || size < (size_t) headerSize) {
+        return false;
+    }
+    
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    const size_t numPresets = juce::ByteOrder::littleEndianInt(bytes + 8);
+    
+    // Entries are checked again whenever one is read, this only guards the index itself
+    return juce::ByteOrder::littleEndianInt(bytes) == magic
+        && juce::ByteOrder::littleEndianShort(bytes + 4) <= currentVersion
+        && numPresets <= (size - (size_t) headerSize) / (size_t) entrySize;
+}
+
+void PresetBank::Bank::setData(const void* newData, size_t newSize)
+{
+    data = static_cast<const juce::uint8*>(newData);
+    size = newSize;
+    numPresets = (int) juce::ByteOrder::littleEndianInt(data + 8);
+}
+
+const juce::uint8* PresetBank::Bank::getEntry(int index) const
+{
+    if(! juce::isPositiveAndBelow(index, numPresets)) {
+        return nullptr;
+    }
+    
+    return data + headerSize + (size_t) index * entrySize;
+}
+
+bool PresetBank::Bank::getName(int index, const char*& name, int& length) const
+{
+    const juce::uint8* entry = getEntry(index);
+    
+    if(entry == nullptr) {
+        return false;
+    }
+    
+    const size_t nameOffset = juce::ByteOrder::littleEndianInt(entry);
+    length = juce::ByteOrder::littleEndianShort(entry + 4);
+    
+    if(nameOffset > size || (size_t) length > size - nameOffset) {
+        return false;
+    }
+    
+    name = reinterpret_cast<const char*>(data + nameOffset);
+    return true;
+}
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    Factory and user presets in one indexed file. The file is memory mapped
+    and every preset is a fixed size entry in an index at its start, so
+    listing or searching thousands of presets only touches the index and the
+    names, and a preset's parameters are decoded only when it is recalled.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginState.h"
+
+//==============================================================================
+/**
+    Layout, every field little endian:
+
+        uint32  magic
+        uint16  version
+        uint16  reserved
+        uint32  numPresets
+        entry   index[numPresets]
+        ...     names and states
+
+    Each index entry is 16 bytes:
+
+        uint32  nameOffset   from the start of the file, UTF-8, not terminated
+        uint16  nameLength
+        uint16  flags        isFactoryFlag
+        uint32  stateOffset  from the start of the file
+        uint32  stateSize    a PluginState of the preset's parameters
+
+    Shared by all processors through juce::SharedResourcePointer. Until the
+    user saves a preset of their own there is no file, and the bank is built
+    in memory from the factory presets. Every version of the bank is built
+    and mapped in full before an atomic pointer swap publishes it, and the
+    version it replaces is only released once no reader holds it any more.
+    Readers never take a lock or wait, so the audio thread can recall a
+    preset while another instance saves one.
+*/
+class PresetBank
+{
+public:
+    PresetBank();
+    ~PresetBank();
+
+    /** Where the bank is kept, the factory presets are served from memory until it exists. */
+    static juce::File getDefaultFile();
+
+    /** Maps the given bank file, falling back to the factory presets if it is missing or invalid, message thread only. */
+    void open(const juce::File& file);
+
+    int getNumPresets() const;
+    juce::String getName(int index) const;
+    bool isFactoryPreset(int index) const;
+
+    /** Indices of every preset whose name contains text, ignoring case, message thread only. */
+    juce::Array<int> search(const juce::String& text) const;
+
+    /**
+        Decodes a preset's fields, in the processor's parameter order, and
+        returns how many it holds or -1 if the index is out of range.
+        Doesn't allocate or wait, so it is safe on the audio thread.
+    */
+    int getFields(int index, float* fields, int maxNumFields) const;
+
+    /** Appends a user preset holding the given PluginState and rewrites the file, message thread only. */
+    bool addUserPreset(const juce::String& name, const juce::MemoryBlock& state);
+
+    static constexpr juce::uint32 magic = 0x4f664342; // "OfCB"
+    static constexpr juce::uint16 currentVersion = 1;
+    static constexpr int headerSize = 12;
+    static constexpr int entrySize = 16;
+    static constexpr juce::uint16 isFactoryFlag = 1;
+
+private:
+    struct Preset
+    {
+        juce::String name;
+        juce::uint16 flags;
+        juce::MemoryBlock state;
+    };
+
+    /** One version of the bank, it never changes once it is published. */
+    struct Bank
+    {
+        // Whichever of these holds the data, the factory bank is the processor's own
+        std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+        juce::MemoryBlock memory;
+
+        const juce::uint8* data = nullptr;
+        size_t size = 0;
+        int numPresets = 0;
+
+        void setData(const void* newData, size_t newSize);
+        const juce::uint8* getEntry(int index) const;
+        bool getName(int index, const char*& name, int& length) const;
+    };
+
+    /** Holds whichever bank is published while it lives, so a swap can't release it. */
+    class ScopedReader
+    {
+    public:
+        explicit ScopedReader(const PresetBank& presetBank);
+        ~ScopedReader();
+
+        const Bank& operator*() const { return *mBank; }
+        const Bank* operator->() const { return mBank; }
+
+    private:
+        const PresetBank& mPresetBank;
+        const Bank* mBank;
+    };
+
+    static void writeBank(const std::vector<Preset>& presets, juce::MemoryBlock& destData);
+    static std::vector<Preset> getFactoryPresets();
+    static bool isValidBank(const void* data, size_t size);
+
+    /** Publishes a new bank and releases the old one once no reader holds it, message thread only. */
+    void publish(std::unique_ptr<Bank> bank);
+
+    juce::File mFile;
+    juce::MemoryBlock mFactoryBank;
+
+    // Readers count themselves in before loading the pointer and out when they are done
+    std::atomic<Bank*> mBank;
+    mutable std::atomic<int> mNumReaders;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeGuard.h"
+
+#include <iostream>
+
+#if OF_CHORUS_REALTIME_CHECKS && JUCE_LINUX
+ #include <dlfcn.h>
+ #include <errno.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // Nonzero while a guard is alive, the depth of nested guards on this thread
+    thread_local int guardDepth = 0;
+
+    std::atomic<int> numViolations { 0 };
+    std::atomic<RealtimeGuard::ViolationHandler> violationHandler { nullptr };
+}
+
+//==============================================================================
+RealtimeGuard::RealtimeGuard()
+{
+    guardDepth++;
+}
+
+RealtimeGuard::~RealtimeGuard()
+{
+    guardDepth--;
+}
+
+void RealtimeGuard::setViolationHandler(ViolationHandler handler)
+{
+    violationHandler = handler;
+}
+
+int RealtimeGuard::getNumViolations()
+{
+    return numViolations.load();
+}
+
+void RealtimeGuard::resetNumViolations()
+{
+    numViolations = 0;
+}
+
+void RealtimeGuard::check(const char* call)
+{
+    if(guardDepth <= 0) {
+        return;
+    }
+    
+    // Reporting allocates and writes, none of which may be reported again
+    const ScopedSuspend suspend;
+    
+    numViolations++;
+    
+    const juce::String stackTrace = juce::SystemStats::getStackBacktrace();
+    
+    if(auto handler = violationHandler.load()) {
+        handler(call, stackTrace);
+        return;
+    }
+    
+    std::cerr << "Real-time violation: " << call << " on the audio thread" << std::endl << stackTrace << std::endl;
+}
+
+RealtimeGuard::ScopedSuspend::ScopedSuspend()
+{
+    mDepth = guardDepth;
+    guardDepth = 0;
+}
+
+RealtimeGuard::ScopedSuspend::~ScopedSuspend()
+{
+    guardDepth = mDepth;
+}
+
+//==============================================================================
+#if OF_CHORUS_REALTIME_CHECKS && JUCE_LINUX
+
+/*
+    The interceptors replace the C library's symbols in the executable, which
+    is why the checks are meant for the command line tools. Allocation goes
+    straight to glibc's own entry points, everything else is looked up once
+    with dlsym outside of any guard.
+*/
+
+namespace
+{
+    template <typename Function>
+    Function getNextSymbol(Function& function, const char* name)
+    {
+        if(function == nullptr) {
+            const RealtimeGuard::ScopedSuspend suspend;
+            function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+        }
+        
+        return function;
+    }
+    
+    int (*nextMutexLock)(pthread_mutex_t*) = nullptr;
+    int (*nextSemWait)(sem_t*) = nullptr;
+    int (*nextNanosleep)(const timespec*, timespec*) = nullptr;
+    int (*nextUsleep)(useconds_t) = nullptr;
+    int (*nextPoll)(pollfd*, nfds_t, int) = nullptr;
+    ssize_t (*nextRead)(int, void*, size_t) = nullptr;
+    ssize_t (*nextWrite)(int, const void*, size_t) = nullptr;
+    
+    // Resolving everything before main, so no lookup ever happens inside a guard
+    [[maybe_unused]] const bool symbolsResolved = [] {
+        getNextSymbol(nextMutexLock, "pthread_mutex_lock");
+        getNextSymbol(nextSemWait, "sem_wait");
+        getNextSymbol(nextNanosleep, "nanosleep");
+        getNextSymbol(nextUsleep, "usleep");
+        getNextSymbol(nextPoll, "poll");
+        getNextSymbol(nextRead, "read");
+        getNextSymbol(nextWrite, "write");
+        return true;
+    }();
+}
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+    
+    void* malloc(size_t size)
+    {
+        RealtimeGuard::check("malloc");
+        return __libc_malloc(size);
+    }
+    
+    void* calloc(size_t count, size_t size)
+    {
+        RealtimeGuard::check("calloc");
+        return __libc_calloc(count, size);
+    }
+    
+    void* realloc(void* pointer, size_t size)
+    {
+        RealtimeGuard::check("realloc");
+        return __libc_realloc(pointer, size);
+    }
+    
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        RealtimeGuard::check("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+    
+    int posix_memalign(void** pointer, size_t alignment, size_t size)
+    {
+        RealtimeGuard::check("posix_memalign");
+        *pointer = __libc_memalign(alignment, size);
+        return *pointer != nullptr ? 0 : ENOMEM;
+    }
+    
+    void free(void* pointer)
+    {
+        if(pointer != nullptr) {
+            RealtimeGuard::check("free");
+        }
+        
+        __libc_free(pointer);
+    }
+    
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        RealtimeGuard::check("pthread_mutex_lock");
+        return getNextSymbol(nextMutexLock, "pthread_mutex_lock")(mutex);
+    }
+    
+    int sem_wait(sem_t* semaphore)
+    {
+        RealtimeGuard::check("sem_wait");
+        return getNextSymbol(nextSemWait, "sem_wait")(semaphore);
+    }
+    
+    int nanosleep(const timespec* duration, timespec* remaining)
+    {
+        RealtimeGuard::check("nanosleep");
+        return getNextSymbol(nextNanosleep, "nanosleep")(duration, remaining);
+    }
+    
+    int usleep(useconds_t microseconds)
+    {
+        RealtimeGuard::check("usleep");
+        return getNextSymbol(nextUsleep, "usleep")(microseconds);
+    }
+    
+    int poll(pollfd* descriptors, nfds_t numDescriptors, int timeout)
+    {
+        RealtimeGuard::check("poll");
+        return getNextSymbol(nextPoll, "poll")(descriptors, numDescriptors, timeout);
+    }
+    
+    ssize_t read(int descriptor, void* buffer, size_t numBytes)
+    {
+        RealtimeGuard::check("read");
+        return getNextSymbol(nextRead, "read")(descriptor, buffer, numBytes);
+    }
+    
+    ssize_t write(int descriptor, const void* buffer, size_t numBytes)
+    {
+        RealtimeGuard::check("write");
+        return getNextSymbol(nextWrite, "write")(descriptor, buffer, numBytes);
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+
+    Debug instrumentation that catches the audio thread doing anything that
+    can block: allocating, locking a mutex or making a blocking system call
+    while processBlock is running. Only compiled in when
+    OF_CHORUS_REALTIME_CHECKS is set, which the CMake option of the same name
+    does for the command line tools. Release plugins carry none of it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef OF_CHORUS_REALTIME_CHECKS
+ #define OF_CHORUS_REALTIME_CHECKS 0
+#endif
+
+//==============================================================================
+/**
+    Marks the current thread as real-time for its lifetime, guards nest.
+
+    On Linux the checks intercept malloc and friends, pthread_mutex_lock,
+    sem_wait, nanosleep, usleep, poll, read and write. Each call made while a
+    guard is alive on the calling thread is a violation, reported with a
+    stack trace to the handler or, without one, to stderr.
+*/
+class RealtimeGuard
+{
+public:
+    RealtimeGuard();
+    ~RealtimeGuard();
+
+    /** Called with what was intercepted and a stack trace, on the offending thread. */
+    using ViolationHandler = void (*)(const char* call, const juce::String& stackTrace);
+    static void setViolationHandler(ViolationHandler handler);
+
+    static int getNumViolations();
+    static void resetNumViolations();
+
+    /** Called by the interceptors, does nothing unless a guard is alive on this thread. */
+    static void check(const char* call);
+
+    /** Lets the calling thread block again for a while, e.g. to report or to log. */
+    class ScopedSuspend
+    {
+    public:
+        ScopedSuspend();
+        ~ScopedSuspend();
+
+    private:
+        int mDepth;
+    };
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeGuard)
+};
+
+#if OF_CHORUS_REALTIME_CHECKS
+ #define OF_CHORUS_REALTIME_SCOPE const RealtimeGuard realtimeGuard;
+#else
+ #define OF_CHORUS_REALTIME_SCOPE
+#endif
@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    TelemetryFifo.cpp
+
+  ==============================================================================
+*/
+
+#include "TelemetryFifo.h"
+
+//==============================================================================
+TelemetryFifo::TelemetryFifo()
+    : mFifo(capacity)
+{
+}
+
+bool TelemetryFifo::push(const TelemetryFrame& frame)
+{
+    const auto scope = mFifo.write(1);
+
+    if(scope.blockSize1 > 0) {
+        mFrames[scope.startIndex1] = frame;
+        return true;
+    }
+
+    return false;
+}
+
+bool TelemetryFifo::pop(TelemetryFrame& frame)
+{
+    const auto scope = mFifo.read(1);
+
+    if(scope.blockSize1 > 0) {
+        frame = mFrames[scope.startIndex1];
+        return true;
+    }
+
+    return false;
+}
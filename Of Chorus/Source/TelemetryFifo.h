@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    TelemetryFifo.h
+
+    Carries decimated modulation and level readings from the audio thread to
+    the editor without locks or allocation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusKernel.h"
+
+//==============================================================================
+/** One reading, taken every TelemetryFifo::frameInterval samples. */
+struct TelemetryFrame
+{
+    static constexpr int maxMeterChannels = ChorusKernel::maxChannels;
+
+    float lfo;
+    float delayMs;
+
+    // The levels of every channel the processor runs, up to maxMeterChannels
+    int numChannels;
+    float peak[maxMeterChannels];
+    float rms[maxMeterChannels];
+};
+
+//==============================================================================
+/**
+    Single producer, single consumer ring of TelemetryFrames built on
+    juce::AbstractFifo. push() is wait-free and only ever called from the audio
+    thread, pop() only from the message thread. When the editor falls behind,
+    new frames are dropped rather than overwriting unread ones.
+*/
+class TelemetryFifo
+{
+public:
+    TelemetryFifo();
+
+    /** Returns false if the ring was full and the frame was dropped. */
+    bool push(const TelemetryFrame& frame);
+    bool pop(TelemetryFrame& frame);
+
+    int getNumReady() const { return mFifo.getNumReady(); }
+
+    static constexpr int capacity = 512;
+    static constexpr int frameInterval = 256;
+
+private:
+    juce::AbstractFifo mFifo;
+    TelemetryFrame mFrames[capacity];
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryFifo)
+};
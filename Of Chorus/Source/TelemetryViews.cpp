@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    TelemetryViews.cpp
+
+  ==============================================================================
+*/
+
+#include "TelemetryViews.h"
+
+//==============================================================================
+LFOScope::LFOScope()
+{
+    for(int i = 0; i < historySize; i++) {
+        mHistory[i] = 0;
+    }
+
+    mHistoryWritePosition = 0;
+    mDelayMs = 0;
+    mHasNewFrames = false;
+
+    setOpaque(true);
+}
+
+void LFOScope::pushFrame(const TelemetryFrame& frame)
+{
+    mHistory[mHistoryWritePosition] = frame.lfo;
+    mHistoryWritePosition = (mHistoryWritePosition + 1) % historySize;
+    mDelayMs = frame.delayMs;
+    mHasNewFrames = true;
+}
+
+void LFOScope::tick()
+{
+    if(mHasNewFrames) {
+        mHasNewFrames = false;
+        repaint();
+    }
+}
+
+void LFOScope::paint(juce::Graphics& g)
+{
+    const auto bounds = getLocalBounds().toFloat().reduced(4.0f);
+
+    g.fillAll(juce::Colours::black);
+
+    g.setColour(juce::Colours::darkgrey);
+    g.drawHorizontalLine((int) bounds.getCentreY(), bounds.getX(), bounds.getRight());
+
+    // Drawing the history oldest first, so the trace scrolls from right to left
+    juce::Path trace;
+
+    for(int i = 0; i < historySize; i++) {
+        const float value = mHistory[(mHistoryWritePosition + i) % historySize];
+        const float x = juce::jmap((float) i, 0.0f, (float) (historySize - 1), bounds.getX(), bounds.getRight());
+        const float y = juce::jmap(value, -1.0f, 1.0f, bounds.getBottom(), bounds.getY());
+
+        if(i == 0) {
+            trace.startNewSubPath(x, y);
+        }
+        else {
+            trace.lineTo(x, y);
+        }
+    }
+
+    g.setColour(juce::Colours::limegreen);
+    g.strokePath(trace, juce::PathStrokeType(1.5f));
+
+    g.setColour(juce::Colours::white);
+    g.setFont(12.0f);
+    g.drawText(juce::String(mDelayMs, 2) + " ms", bounds.toNearestInt(), juce::Justification::topLeft);
+}
+
+//==============================================================================
+LevelMeter::LevelMeter()
+{
+    mNumChannels = 2;
+
+    for(int channel = 0; channel < TelemetryFrame::maxMeterChannels; channel++) {
+        mPeak[channel] = 0;
+        mRms[channel] = 0;
+        mDisplayedPeak[channel] = 0;
+        mDisplayedRms[channel] = 0;
+    }
+
+    setOpaque(true);
+}
+
+void LevelMeter::setNumChannels(int numChannels)
+{
+    numChannels = juce::jlimit(1, TelemetryFrame::maxMeterChannels, numChannels);
+
+    if(numChannels == mNumChannels) {
+        return;
+    }
+
+    // Bars that come and go start from silence
+    for(int channel = juce::jmin(numChannels, mNumChannels); channel < TelemetryFrame::maxMeterChannels; channel++) {
+        mPeak[channel] = 0;
+        mRms[channel] = 0;
+        mDisplayedPeak[channel] = 0;
+        mDisplayedRms[channel] = 0;
+    }
+
+    mNumChannels = numChannels;
+    repaint();
+}
+
+void LevelMeter::pushFrame(const TelemetryFrame& frame)
+{
+    // The bus layout can change while the editor is open
+    setNumChannels(frame.numChannels);
+
+    // Holding the loudest frame until the next tick
+    for(int channel = 0; channel < mNumChannels; channel++) {
+        mPeak[channel] = juce::jmax(mPeak[channel], frame.peak[channel]);
+        mRms[channel] = juce::jmax(mRms[channel], frame.rms[channel]);
+    }
+}
+
+void LevelMeter::tick()
+{
+    bool changed = false;
+
+    for(int channel = 0; channel < mNumChannels; channel++) {
+        const float peak = juce::jmax(mPeak[channel], mDisplayedPeak[channel] * releasePerTick);
+        const float rms = juce::jmax(mRms[channel], mDisplayedRms[channel] * releasePerTick);
+
+        // Only repainting for changes above the bottom of the scale
+        if(std::abs(peak - mDisplayedPeak[channel]) > 1.0e-4f || std::abs(rms - mDisplayedRms[channel]) > 1.0e-4f) {
+            changed = true;
+        }
+
+        mDisplayedPeak[channel] = peak;
+        mDisplayedRms[channel] = rms;
+        mPeak[channel] = 0;
+        mRms[channel] = 0;
+    }
+
+    if(changed) {
+        repaint();
+    }
+}
+
+void LevelMeter::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    const auto bounds = getLocalBounds().toFloat().reduced(4.0f);
+    const float barWidth = bounds.getWidth() / (float) mNumChannels;
+    const float barGap = juce::jmin(2.0f, barWidth * 0.1f);
+
+    auto toHeight = [&bounds](float gain) {
+        const float decibels = juce::Decibels::gainToDecibels(gain, minimumDecibels);
+        return juce::jmap(decibels, minimumDecibels, 0.0f, 0.0f, bounds.getHeight());
+    };
+
+    for(int channel = 0; channel < mNumChannels; channel++) {
+        const auto bar = bounds.withX(bounds.getX() + barWidth * (float) channel).withWidth(barWidth).reduced(barGap, 0.0f);
+
+        const float rmsHeight = juce::jmin(toHeight(mDisplayedRms[channel]), bar.getHeight());
+        const float peakHeight = juce::jmin(toHeight(mDisplayedPeak[channel]), bar.getHeight());
+
+        g.setColour(juce::Colours::darkgrey);
+        g.fillRect(bar);
+
+        g.setColour(juce::Colours::limegreen);
+        g.fillRect(bar.withTop(bar.getBottom() - rmsHeight));
+
+        g.setColour(mDisplayedPeak[channel] >= 1.0f ? juce::Colours::red : juce::Colours::white);
+        g.fillRect(bar.withTop(bar.getBottom() - peakHeight).withHeight(2.0f));
+    }
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    TelemetryViews.h
+
+    Scope and level meters the editor feeds from the processor's TelemetryFifo.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TelemetryFifo.h"
+
+//==============================================================================
+/**
+    Scrolling trace of the LFO with the current delay time printed over it.
+*/
+class LFOScope  : public juce::Component
+{
+public:
+    LFOScope();
+
+    void pushFrame(const TelemetryFrame& frame);
+
+    /** Repaints if any frames arrived since the last tick. */
+    void tick();
+
+    void paint(juce::Graphics& g) override;
+
+    static constexpr int historySize = 256;
+
+private:
+    float mHistory[historySize];
+    int mHistoryWritePosition;
+    float mDelayMs;
+    bool mHasNewFrames;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LFOScope)
+};
+
+//==============================================================================
+/**
+    Peak and RMS bars for up to TelemetryFrame::maxMeterChannels channels,
+    with the usual instant attack and gradual release. Shows as many bars as
+    the last frame carried channels.
+*/
+class LevelMeter  : public juce::Component
+{
+public:
+    LevelMeter();
+
+    void setNumChannels(int numChannels);
+    int getNumChannels() const { return mNumChannels; }
+
+    void pushFrame(const TelemetryFrame& frame);
+
+    /** Applies the release and repaints if the displayed levels moved. */
+    void tick();
+
+    void paint(juce::Graphics& g) override;
+
+    static constexpr float releasePerTick = 0.85f;
+    static constexpr float minimumDecibels = -60.0f;
+
+private:
+    int mNumChannels;
+
+    float mPeak[TelemetryFrame::maxMeterChannels];
+    float mRms[TelemetryFrame::maxMeterChannels];
+
+    float mDisplayedPeak[TelemetryFrame::maxMeterChannels];
+    float mDisplayedRms[TelemetryFrame::maxMeterChannels];
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
+};
@@ -0,0 +1,345 @@
+/*
+  ==============================================================================
+
+    Offline batch renderer.
+
+    Streams audio files through OfChorusAudioProcessor on a thread pool, one
+    processor instance per file, and writes the results next to the inputs or
+    into an output folder. Files are read and written in chunks, so stems of
+    any length render in constant memory. The feedback tail is rendered after
+    the end of each input.
+
+    Usage: OfChorusRender [--preset <name>] [--state <file>] [--threads <n>] [--chunk <n>]
+                          [--output <dir>] [--format wav|flac|aiff] [--scaling] <file>...
+
+    --preset recalls the first preset in the bank whose name contains the
+    given text, --state loads a state blob saved by the plugin. A state is
+    applied after a preset.
+
+    --threads sets the size of the pool, by default one thread per core.
+
+    --scaling renders the whole batch with 1, 2, 4... threads up to --threads
+    and reports how close the throughput comes to scaling linearly.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    struct Settings
+    {
+        juce::String preset;
+        juce::MemoryBlock state;
+        int chunkSize = 65536;
+        juce::File outputDirectory;
+        juce::String format;
+    };
+
+    struct RenderResult
+    {
+        juce::File input;
+        juce::String error;
+        double audioSeconds = 0;
+        double renderSeconds = 0;
+    };
+
+    //==============================================================================
+    /** Renders one file with its own processor, nothing but the format manager is shared. */
+    class RenderJob  : public juce::ThreadPoolJob
+    {
+    public:
+        RenderJob(const juce::File& input, const Settings& settings, juce::AudioFormatManager& formatManager, RenderResult& result)
+            : juce::ThreadPoolJob("Render " + input.getFileName()), mInput(input), mSettings(settings), mFormatManager(formatManager), mResult(result)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+
+            mResult.input = mInput;
+            mResult.error = render();
+
+            const auto end = std::chrono::high_resolution_clock::now();
+            mResult.renderSeconds = std::chrono::duration<double>(end - start).count();
+
+            return jobHasFinished;
+        }
+
+    private:
+        juce::String render()
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader(mFormatManager.createReaderFor(mInput));
+
+            if(reader == nullptr) {
+                return "unreadable or unsupported format";
+            }
+
+            const int numChannels = (int) reader->numChannels;
+            const double sampleRate = reader->sampleRate;
+
+            if(numChannels > ChorusKernel::maxChannels) {
+                return "more than " + juce::String(ChorusKernel::maxChannels) + " channels";
+            }
+
+            // Writing the same format as the input unless another one was asked for
+            const juce::String extension = mSettings.format.isNotEmpty() ? "." + mSettings.format : mInput.getFileExtension();
+            auto* format = mFormatManager.findFormatForFileExtension(extension);
+
+            if(format == nullptr) {
+                return "no writer for " + extension;
+            }
+
+            const juce::File directory = mSettings.outputDirectory != juce::File() ? mSettings.outputDirectory : mInput.getParentDirectory();
+            const juce::File output = directory.getChildFile(mInput.getFileNameWithoutExtension() + ".chorus" + extension);
+
+            // Keeping the input's bit depth where the output format supports it
+            const auto bitDepths = format->getPossibleBitDepths();
+            const int bitsPerSample = bitDepths.contains((int) reader->bitsPerSample) ? (int) reader->bitsPerSample : bitDepths.getLast();
+
+            output.deleteFile();
+            auto stream = std::make_unique<juce::FileOutputStream>(output);
+
+            if(stream->failedToOpen()) {
+                return "cannot write " + output.getFullPathName();
+            }
+
+            std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                      bitsPerSample, reader->metadataValues, 0));
+
+            if(writer == nullptr) {
+                return "cannot encode " + juce::String(numChannels) + " channels at " + juce::String(bitsPerSample) + " bits";
+            }
+
+            // The writer owns the stream from here on
+            stream.release();
+
+            OfChorusAudioProcessor processor;
+
+            if(mSettings.preset.isNotEmpty()) {
+                const auto found = processor.getPresetBank().search(mSettings.preset);
+
+                if(found.isEmpty()) {
+                    return "no preset matching '" + mSettings.preset + "'";
+                }
+
+                processor.setCurrentProgram(found.getFirst());
+            }
+
+            if(! mSettings.state.isEmpty()) {
+                processor.setStateInformation(mSettings.state.getData(), (int) mSettings.state.getSize());
+            }
+
+            processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, mSettings.chunkSize);
+            processor.setNonRealtime(true);
+            processor.prepareToPlay(sampleRate, mSettings.chunkSize);
+
+            juce::AudioBuffer<float> buffer(numChannels, mSettings.chunkSize);
+            juce::MidiBuffer midi;
+
+            const juce::int64 inputLength = reader->lengthInSamples;
+            const juce::int64 tailLength = (juce::int64) (processor.getTailLengthSeconds() * sampleRate);
+
+            for(juce::int64 position = 0; position < inputLength + tailLength && ! shouldExit(); position += mSettings.chunkSize) {
+                const int numSamples = (int) juce::jmin((juce::int64) mSettings.chunkSize, inputLength + tailLength - position);
+
+                buffer.setSize(numChannels, numSamples, false, false, true);
+
+                // Past the end of the input the reader fills in silence for the tail
+                reader->read(&buffer, 0, numSamples, position, true, true);
+                processor.processBlock(buffer, midi);
+
+                if(! writer->writeFromAudioSampleBuffer(buffer, 0, numSamples)) {
+                    return "write failed";
+                }
+            }
+
+            processor.releaseResources();
+
+            mResult.audioSeconds = (double) inputLength / sampleRate;
+            return {};
+        }
+
+        juce::File mInput;
+        const Settings& mSettings;
+        juce::AudioFormatManager& mFormatManager;
+        RenderResult& mResult;
+    };
+
+    //==============================================================================
+    /** Renders every input on numThreads threads and returns the wall clock time in seconds. */
+    double renderAll(const juce::Array<juce::File>& inputs, const Settings& settings, juce::AudioFormatManager& formatManager,
+                     int numThreads, std::vector<RenderResult>& results)
+    {
+        results.assign((size_t) inputs.size(), {});
+
+        juce::ThreadPool pool(numThreads);
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        for(int i = 0; i < inputs.size(); i++) {
+            pool.addJob(new RenderJob(inputs[i], settings, formatManager, results[(size_t) i]), true);
+        }
+
+        while(pool.getNumJobs() > 0) {
+            juce::Thread::sleep(10);
+        }
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    double getTotalAudioSeconds(const std::vector<RenderResult>& results)
+    {
+        double total = 0;
+
+        for(const auto& result : results) {
+            total += result.audioSeconds;
+        }
+
+        return total;
+    }
+
+    void printResults(const std::vector<RenderResult>& results, double wallSeconds, int numThreads)
+    {
+        int failures = 0;
+
+        for(const auto& result : results) {
+            std::cout << "  " << result.input.getFileName().paddedRight(' ', 40);
+
+            if(result.error.isNotEmpty()) {
+                std::cout << "failed: " << result.error << std::endl;
+                failures++;
+                continue;
+            }
+
+            std::cout << juce::String(result.audioSeconds, 1).paddedLeft(' ', 9) << " s"
+                      << juce::String(result.audioSeconds / result.renderSeconds, 1).paddedLeft(' ', 10) << " x rtime" << std::endl;
+        }
+
+        const double audioSeconds = getTotalAudioSeconds(results);
+
+        std::cout << results.size() - (size_t) failures << " of " << results.size() << " files, "
+                  << juce::String(audioSeconds, 1) << " s of audio in " << juce::String(wallSeconds, 2) << " s on "
+                  << numThreads << " threads: " << juce::String(audioSeconds / wallSeconds, 1) << " x rtime" << std::endl;
+    }
+
+    void printScaling(const juce::Array<juce::File>& inputs, const Settings& settings, juce::AudioFormatManager& formatManager, int maxThreads)
+    {
+        std::vector<RenderResult> results;
+        double singleThreadRate = 0;
+
+        std::cout << "threads   x rtime   efficiency" << std::endl;
+
+        for(int numThreads = 1; ; numThreads = juce::jmin(numThreads * 2, maxThreads)) {
+            const double wallSeconds = renderAll(inputs, settings, formatManager, numThreads, results);
+            const double rate = getTotalAudioSeconds(results) / wallSeconds;
+
+            if(numThreads == 1) {
+                singleThreadRate = rate;
+            }
+
+            // 100% means n threads render exactly n times as fast as one
+            std::cout << juce::String(numThreads).paddedLeft(' ', 7)
+                      << juce::String(rate, 1).paddedLeft(' ', 10)
+                      << juce::String(100.0 * rate / (singleThreadRate * numThreads), 1).paddedLeft(' ', 12) << "%" << std::endl;
+
+            if(numThreads == maxThreads) {
+                break;
+            }
+        }
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    Settings settings;
+    settings.preset = args.getValueForOption("--preset");
+    settings.format = args.getValueForOption("--format").trimCharactersAtStart(".").toLowerCase();
+
+    if(args.containsOption("--chunk")) {
+        settings.chunkSize = juce::jmax(1, args.getValueForOption("--chunk").getIntValue());
+    }
+
+    const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+    if(args.containsOption("--output")) {
+        settings.outputDirectory = workingDirectory.getChildFile(args.getValueForOption("--output"));
+
+        if(settings.outputDirectory.createDirectory().failed()) {
+            std::cerr << "Cannot create " << settings.outputDirectory.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if(args.containsOption("--state") && ! workingDirectory.getChildFile(args.getValueForOption("--state")).loadFileAsData(settings.state)) {
+        std::cerr << "Cannot read " << args.getValueForOption("--state") << std::endl;
+        return 1;
+    }
+
+    const int numThreads = args.containsOption("--threads") ? juce::jmax(1, args.getValueForOption("--threads").getIntValue())
+                                                            : juce::SystemStats::getNumCpus();
+    const bool scaling = args.containsOption("--scaling");
+
+    // Everything left after the options is an input file
+    juce::Array<juce::File> inputs;
+
+    for(int i = 0; i < args.size(); i++) {
+        const auto& argument = args[i];
+
+        if(argument.isOption()) {
+            // Options with a separate value swallow the next argument
+            if(argument != "--scaling" && ! argument.text.containsChar('=') && i + 1 < args.size() && ! args[i + 1].isOption()) {
+                i++;
+            }
+
+            continue;
+        }
+
+        const auto input = workingDirectory.getChildFile(argument.text);
+
+        if(! input.existsAsFile()) {
+            std::cerr << "Cannot find " << input.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        inputs.add(input);
+    }
+
+    if(inputs.isEmpty()) {
+        std::cerr << "Usage: OfChorusRender [--preset <name>] [--state <file>] [--threads <n>] [--chunk <n>]" << std::endl
+                  << "                      [--output <dir>] [--format wav|flac|aiff] [--scaling] <file>..." << std::endl;
+        return 1;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    if(scaling) {
+        printScaling(inputs, settings, formatManager, numThreads);
+        return 0;
+    }
+
+    std::vector<RenderResult> results;
+    const double wallSeconds = renderAll(inputs, settings, formatManager, numThreads, results);
+    printResults(results, wallSeconds, numThreads);
+
+    for(const auto& result : results) {
+        if(result.error.isNotEmpty()) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,879 @@
+/*
+  ==============================================================================
+
+    Headless processBlock benchmark.
+
+    Drives OfChorusAudioProcessor over a grid of sample rates, block sizes and
+    effect types and reports ns/sample, real-time factor and block time
+    percentiles. The original scalar loop and juce::dsp::Chorus are run over
+    the same grid as baselines.
+
+    Usage: OfChorusBenchmark [--seconds <s>] [--rate <hz>] [--block <n>] [--voices <n>]
+                             [--channels <n>] [--double] [--interpolation] [--silence] [--csv]
+           OfChorusBenchmark --lfo [--seconds <s>]
+           OfChorusBenchmark --control [--seconds <s>]
+           OfChorusBenchmark --engine [--seconds <s>]
+           OfChorusBenchmark --telemetry [--seconds <s>]
+           OfChorusBenchmark --envelope [--seconds <s>]
+           OfChorusBenchmark --pool [--instances <n>]
+           OfChorusBenchmark --state [--instances <n>]
+
+    --lfo checks LFOEngine against std::sin over a long render and compares
+    its throughput with the two std::sin calls per sample it replaced. It
+    fails if the error grows beyond 1e-6.
+
+    --double runs the processor on double buffers, once through its native double
+    path and once through a float copy the way a host wraps float-only plugins.
+
+    --interpolation runs the processor once per fractional delay interpolator
+    so the cost of each quality level can be compared.
+
+    --silence adds a run on digital silence, which the processor should
+    detect and idle through once its feedback tail has died away.
+
+    --control renders the kernel with the delay times recomputed every sample
+    and at every control interval, and reports the cost of each interval and
+    how far its output strays from the per sample render. It fails if any
+    interval strays by more than -40 dB.
+
+    --engine renders the kernel with the per-sample and the block engine for
+    every type, interpolator and a few voice and channel counts at 44.1 kHz,
+    where the flanger's shortest delay is under 40 samples, and fails if the
+    two outputs differ by more than float rounding.
+
+    --telemetry times the processor with the editor's telemetry off and on and
+    reports the overhead, and fails if it isn't below 1%.
+
+    --envelope times the processor with the envelope follower off and
+    modulating depth, rate and mix, and reports the overhead.
+
+    --pool prepares many instances at rising sample rates and reports how much
+    memory the shared DelayLinePool holds.
+
+    --state saves and recalls the state of many instances with random
+    parameters, in the binary format and in the legacy XML format, and
+    reports the time per instance and the size of each state.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "DelayLinePool.h"
+#include "LFOEngine.h"
+#include "ReferenceChorus.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const int blockSizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    const int stereo = 2;
+
+    struct Result
+    {
+        juce::String engine;
+        juce::String mode;
+        double sampleRate = 0;
+        int blockSize = 0;
+        double nsPerSample = 0;
+        double realTimeFactor = 0;
+        double p50Micros = 0;
+        double p99Micros = 0;
+        double maxMicros = 0;
+    };
+
+    // Sets a processor parameter by ID from its un-normalised value
+    void setParameter(juce::AudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        for(auto* parameter : processor.getParameters()) {
+            if(auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter)) {
+                if(ranged->getParameterID() == parameterID) {
+                    ranged->setValueNotifyingHost(ranged->convertTo0to1(value));
+                    return;
+                }
+            }
+        }
+
+        jassertfalse;
+    }
+
+    template <typename SampleType>
+    void fillWithNoise(juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+    {
+        for(int channel = 0; channel < buffer.getNumChannels(); channel++) {
+            SampleType* samples = buffer.getWritePointer(channel);
+
+            for(int i = 0; i < buffer.getNumSamples(); i++) {
+                samples[i] = (SampleType) (random.nextFloat() * 2.0f - 1.0f);
+            }
+        }
+    }
+
+    // Runs processBlockFunction over the given amount of audio and times every block
+    template <typename SampleType = float, typename ProcessFunction>
+    Result measure(double sampleRate, int blockSize, int numChannels, double seconds, ProcessFunction&& processBlockFunction, bool silent = false)
+    {
+        const int numBlocks = juce::jmax(1, (int) (sampleRate * seconds) / blockSize);
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        juce::Random random(0x5eed);
+
+        std::vector<double> blockTimes;
+        blockTimes.reserve((size_t) numBlocks);
+
+        // Warming up caches and branch predictors before measuring
+        for(int block = 0; block < juce::jmin(numBlocks, 64); block++) {
+            fillWithNoise(buffer, random);
+            processBlockFunction(buffer);
+        }
+
+        // A silent run starts timing once the warmup's tail has had time to die away
+        if(silent) {
+            buffer.clear();
+
+            for(int block = 0; block < (int) (sampleRate * 30.0) / blockSize; block++) {
+                processBlockFunction(buffer);
+            }
+        }
+
+        double totalSeconds = 0;
+
+        for(int block = 0; block < numBlocks; block++) {
+            if(silent) {
+                buffer.clear();
+            }
+            else {
+                fillWithNoise(buffer, random);
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            processBlockFunction(buffer);
+            const auto end = std::chrono::steady_clock::now();
+
+            const double elapsed = std::chrono::duration<double>(end - start).count();
+            blockTimes.push_back(elapsed);
+            totalSeconds += elapsed;
+        }
+
+        std::sort(blockTimes.begin(), blockTimes.end());
+
+        auto percentile = [&blockTimes](double p) {
+            const auto index = (size_t) juce::jlimit(0.0, (double) blockTimes.size() - 1, p * (double) (blockTimes.size() - 1));
+            return blockTimes[index] * 1.0e6;
+        };
+
+        const double totalSamples = (double) numBlocks * blockSize;
+
+        Result result;
+        result.sampleRate = sampleRate;
+        result.blockSize = blockSize;
+        result.nsPerSample = totalSeconds * 1.0e9 / totalSamples;
+        result.realTimeFactor = (totalSamples / sampleRate) / juce::jmax(totalSeconds, 1.0e-12);
+        result.p50Micros = percentile(0.5);
+        result.p99Micros = percentile(0.99);
+        result.maxMicros = blockTimes.back() * 1.0e6;
+        return result;
+    }
+
+    Result measureProcessor(double sampleRate, int blockSize, int numChannels, int type, int voices, int interpolation, double seconds, bool silent = false)
+    {
+        OfChorusAudioProcessor processor;
+        setParameter(processor, "type", (float) type);
+        setParameter(processor, "voices", (float) voices);
+        setParameter(processor, "interpolation", (float) interpolation);
+
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::MidiBuffer midi;
+
+        auto result = measure(sampleRate, blockSize, numChannels, seconds, [&](juce::AudioBuffer<float>& buffer) {
+            processor.processBlock(buffer, midi);
+        }, silent);
+
+        processor.releaseResources();
+
+        result.engine = silent ? "OfChorus idle" : "OfChorus";
+
+        if(numChannels != stereo) {
+            result.engine << " " << numChannels << "ch";
+        }
+
+        if(voices > 1) {
+            result.engine << " " << voices << "v";
+        }
+
+        if(interpolation != (int) InterpolationType::linear) {
+            result.engine << " " << getInterpolationTypeNames()[interpolation].toLowerCase();
+        }
+
+        result.mode = getEffectTypeNames()[type];
+        return result;
+    }
+
+    // Runs double buffers either natively or through a float copy, as hosts do for float-only plugins
+    Result measureProcessorDouble(double sampleRate, int blockSize, int numChannels, int type, int voices, double seconds, bool native)
+    {
+        OfChorusAudioProcessor processor;
+        setParameter(processor, "type", (float) type);
+        setParameter(processor, "voices", (float) voices);
+
+        processor.setProcessingPrecision(native ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::MidiBuffer midi;
+        juce::AudioBuffer<float> floatBuffer(numChannels, blockSize);
+
+        auto result = measure<double>(sampleRate, blockSize, numChannels, seconds, [&](juce::AudioBuffer<double>& buffer) {
+            if(native) {
+                processor.processBlock(buffer, midi);
+                return;
+            }
+
+            floatBuffer.makeCopyOf(buffer, true);
+            processor.processBlock(floatBuffer, midi);
+            buffer.makeCopyOf(floatBuffer, true);
+        });
+
+        processor.releaseResources();
+
+        result.engine = native ? "OfChorus double" : "OfChorus dbl>flt";
+        result.mode = getEffectTypeNames()[type];
+        return result;
+    }
+
+    // The original per-sample scalar loop with the processor's default parameters
+    Result measureReference(double sampleRate, int blockSize, int type, double seconds)
+    {
+        ChorusKernel::Parameters parameters;
+        parameters.dryWet = 0.5f;
+        parameters.depth = 0.5f;
+        parameters.rate = 10.0f;
+        parameters.phaseOffset = 0.0f;
+        parameters.feedback = 0.5f;
+        parameters.type = type;
+        parameters.voices = 1;
+        parameters.interpolation = (int) InterpolationType::linear;
+
+        ReferenceChorus reference;
+        reference.prepare(sampleRate);
+
+        auto result = measure(sampleRate, blockSize, stereo, seconds, [&](juce::AudioBuffer<float>& buffer) {
+            reference.process(buffer, parameters);
+        });
+
+        result.engine = "OfChorus scalar";
+        result.mode = getEffectTypeNames()[type];
+        return result;
+    }
+
+    // juce::dsp::Chorus configured to roughly match our default settings
+    Result measureJuceChorus(double sampleRate, int blockSize, int numChannels, int type, double seconds)
+    {
+        juce::dsp::Chorus<float> chorus;
+        chorus.prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+        chorus.setRate(10.0f);
+        chorus.setDepth(0.5f);
+        chorus.setCentreDelay(type == 0 ? 17.5f : 3.0f);
+        chorus.setFeedback(0.5f);
+        chorus.setMix(0.5f);
+
+        auto result = measure(sampleRate, blockSize, numChannels, seconds, [&](juce::AudioBuffer<float>& buffer) {
+            juce::dsp::AudioBlock<float> block(buffer);
+            chorus.process(juce::dsp::ProcessContextReplacing<float>(block));
+        });
+
+        result.engine = "juce::dsp::Chorus";
+        result.mode = getEffectTypeNames()[type];
+        return result;
+    }
+
+    // Compares LFOEngine against std::sin of an exactly computed phase and times both
+    bool runLFOBenchmark(double seconds)
+    {
+        const double sampleRate = 48000.0;
+        const float rate = 19.3f;
+
+        // Float output rounding is around 6e-8, drift from the recursion would grow far beyond this over a long render
+        const double maxErrorLimit = 1.0e-6;
+        const int blockSize = ChorusKernel::chunkSize;
+        const juce::int64 numSamples = (juce::int64) (sampleRate * seconds);
+        const double phaseIncrement = (double) rate / sampleRate;
+
+        LFOEngine lfo;
+        lfo.prepare(sampleRate);
+        lfo.setRate(rate);
+
+        std::vector<float> sinOut((size_t) blockSize);
+        std::vector<float> cosOut((size_t) blockSize);
+
+        double maxError = 0;
+        double lfoSeconds = 0;
+
+        for(juce::int64 start = 0; start < numSamples; start += blockSize) {
+            const int numBlockSamples = (int) juce::jmin((juce::int64) blockSize, numSamples - start);
+
+            const auto begin = std::chrono::steady_clock::now();
+            lfo.process(sinOut.data(), cosOut.data(), numBlockSamples);
+            lfoSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+            for(int i = 0; i < numBlockSamples; i++) {
+                const double phase = std::fmod((double) (start + i) * phaseIncrement, 1.0);
+                const double error = std::abs(sinOut[(size_t) i] - std::sin(juce::MathConstants<double>::twoPi * phase));
+                maxError = juce::jmax(maxError, error);
+            }
+        }
+
+        // The replaced code: one std::sin per channel per sample with a float phase
+        float phase = 0;
+        volatile float sink = 0;
+
+        const auto begin = std::chrono::steady_clock::now();
+
+        for(juce::int64 i = 0; i < numSamples; i++) {
+            sink += (float) sin(2 * M_PI * phase);
+            sink += (float) sin(2 * M_PI * (phase + 0.25f));
+            phase += (float) phaseIncrement;
+
+            if(phase > 1) {
+                phase -= 1;
+            }
+        }
+
+        const double sinSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        std::cout << "LFOEngine over " << seconds << " s at " << sampleRate << " Hz, rate " << rate << " Hz" << std::endl;
+        std::cout << "  max abs error vs std::sin: " << maxError << ", limit " << maxErrorLimit
+                  << (maxError <= maxErrorLimit ? "" : "  over limit") << std::endl;
+        std::cout << "  LFOEngine ns/sample (sin + cos): " << lfoSeconds * 1.0e9 / (double) numSamples << std::endl;
+        std::cout << "  2x std::sin ns/sample:           " << sinSeconds * 1.0e9 / (double) numSamples << std::endl;
+
+        return maxError <= maxErrorLimit;
+    }
+
+    // Renders the same input through the kernel at every control interval, compares against interval 1 and returns whether all are within the threshold
+    bool runControlRateReport(double seconds)
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        const int numSamples = juce::jmax(1, (int) (sampleRate * seconds) / blockSize) * blockSize;
+        const float rates[] = { 0.5f, 5.0f, 20.0f };
+        const int intervals[] = { 1, 4, 8, 16, 32, 64 };
+
+        // Full band noise is the worst case, the error grows with the input's frequency
+        const double errorThresholdDecibels = -40.0;
+        bool allWithin = true;
+
+        juce::AudioBuffer<float> input(stereo, numSamples);
+        juce::Random random(0x5eed);
+        fillWithNoise(input, random);
+
+        std::cout << "Control rate modulation at " << sampleRate << " Hz, depth 1, 3 voices, "
+                  << "error threshold " << errorThresholdDecibels << " dB rms relative to the output" << std::endl;
+
+        for(int type = 0; type < 2; type++) {
+            for(float rate : rates) {
+                ChorusKernel::Parameters parameters;
+                parameters.dryWet = 0.5f;
+                parameters.depth = 1.0f;
+                parameters.rate = rate;
+                parameters.phaseOffset = 0.25f;
+                parameters.feedback = 0.5f;
+                parameters.type = type;
+                parameters.voices = 3;
+                parameters.interpolation = (int) InterpolationType::linear;
+
+                juce::AudioBuffer<float> reference;
+                juce::AudioBuffer<float> output;
+
+                for(int interval : intervals) {
+                    auto kernel = std::make_unique<ChorusKernel>();
+                    kernel->prepare(sampleRate, stereo);
+                    kernel->setControlInterval(interval);
+
+                    output.makeCopyOf(input);
+
+                    const auto begin = std::chrono::steady_clock::now();
+
+                    for(int start = 0; start < numSamples; start += blockSize) {
+                        float* channels[] = { output.getWritePointer(0, start), output.getWritePointer(1, start) };
+                        kernel->process(channels, stereo, blockSize, parameters);
+                    }
+
+                    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+                    if(interval == 1) {
+                        reference.makeCopyOf(output);
+                    }
+
+                    double errorSquares = 0;
+                    double signalSquares = 0;
+
+                    for(int channel = 0; channel < stereo; channel++) {
+                        const float* expected = reference.getReadPointer(channel);
+                        const float* actual = output.getReadPointer(channel);
+
+                        for(int i = 0; i < numSamples; i++) {
+                            errorSquares += juce::square((double) actual[i] - expected[i]);
+                            signalSquares += juce::square((double) expected[i]);
+                        }
+                    }
+
+                    const double errorDecibels = juce::Decibels::gainToDecibels(std::sqrt(errorSquares / juce::jmax(signalSquares, 1.0e-30)), -200.0);
+                    const bool within = errorDecibels < errorThresholdDecibels;
+
+                    std::cout << "  " << getEffectTypeNames()[type].paddedRight(' ', 8)
+                              << juce::String(rate, 1).paddedLeft(' ', 5) << " Hz, interval " << juce::String(interval).paddedLeft(' ', 2) << ": "
+                              << juce::String(elapsed * 1.0e9 / (double) numSamples, 2).paddedLeft(' ', 7) << " ns/sample, error "
+                              << juce::String(errorDecibels, 1).paddedLeft(' ', 7) << " dB"
+                              << (within ? "" : "  over threshold") << std::endl;
+
+                    allWithin = allWithin && within;
+                }
+            }
+        }
+
+        return allWithin;
+    }
+
+    // Renders the same input with both kernel engines, compares them and returns whether they match
+    bool runEngineReport(double seconds)
+    {
+        const double sampleRate = 44100.0;
+        const int blockSize = 512;
+        const int numSamples = juce::jmax(1, (int) (sampleRate * seconds) / blockSize) * blockSize;
+        const int voiceCounts[] = { 1, 3, ChorusKernel::maxVoices };
+
+        // Both engines run the same float operations, only contracted multiply-adds may round differently
+        const double maxErrorThreshold = 1.0e-5;
+
+        juce::AudioBuffer<float> input(stereo, numSamples);
+        juce::Random random(0x5eed);
+        fillWithNoise(input, random);
+
+        std::cout << "Kernel engines at " << sampleRate << " Hz, depth 1, feedback 0.9, "
+                  << "max abs error threshold " << maxErrorThreshold << std::endl;
+
+        bool allMatch = true;
+
+        for(int type = 0; type < numEffectTypes; type++) {
+            for(int voices : voiceCounts) {
+                for(int numChannels = 1; numChannels <= stereo; numChannels++) {
+                    for(int interpolation = 0; interpolation < numInterpolationTypes; interpolation++) {
+                        ChorusKernel::Parameters parameters;
+                        parameters.dryWet = 0.5f;
+                        parameters.depth = 1.0f;
+                        parameters.rate = 5.0f;
+                        parameters.phaseOffset = 0.25f;
+                        parameters.feedback = 0.9f;
+                        parameters.type = type;
+                        parameters.voices = voices;
+                        parameters.interpolation = interpolation;
+                        parameters = ChorusKernel::applyEffectType(parameters);
+
+                        juce::AudioBuffer<float> outputs[2];
+                        double nanosecondsPerSample[2];
+
+                        for(int engine = 0; engine < 2; engine++) {
+                            auto kernel = std::make_unique<ChorusKernel>();
+                            kernel->prepare(sampleRate, numChannels);
+                            kernel->setEngine((ChorusKernel::Engine) engine);
+
+                            auto& output = outputs[engine];
+                            output.makeCopyOf(input);
+
+                            const auto begin = std::chrono::steady_clock::now();
+
+                            for(int start = 0; start < numSamples; start += blockSize) {
+                                float* channels[] = { output.getWritePointer(0, start), output.getWritePointer(1, start) };
+                                kernel->process(channels, numChannels, blockSize, parameters);
+                            }
+
+                            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                            nanosecondsPerSample[engine] = elapsed * 1.0e9 / (double) numSamples;
+                        }
+
+                        double maxError = 0;
+
+                        for(int channel = 0; channel < numChannels; channel++) {
+                            const float* expected = outputs[0].getReadPointer(channel);
+                            const float* actual = outputs[1].getReadPointer(channel);
+
+                            for(int i = 0; i < numSamples; i++) {
+                                maxError = juce::jmax(maxError, std::abs((double) actual[i] - expected[i]));
+                            }
+                        }
+
+                        const bool match = maxError <= maxErrorThreshold;
+                        allMatch = allMatch && match;
+
+                        std::cout << "  " << getEffectTypeNames()[type].paddedRight(' ', 8)
+                                  << juce::String(voices) << " voices, " << numChannels << " ch, "
+                                  << getInterpolationTypeNames()[interpolation].paddedRight(' ', 8) << " per-sample "
+                                  << juce::String(nanosecondsPerSample[0], 2).paddedLeft(' ', 7) << " ns/sample, block "
+                                  << juce::String(nanosecondsPerSample[1], 2).paddedLeft(' ', 7) << " ns/sample, max abs error " << maxError
+                                  << (match ? "" : "  over threshold") << std::endl;
+                    }
+                }
+            }
+        }
+
+        return allMatch;
+    }
+
+    // Times the processor with telemetry off and on, keeping the fastest of a few alternating runs of each
+    bool runTelemetryReport(double seconds)
+    {
+        const double sampleRate = 48000.0;
+        const int reportBlockSizes[] = { 32, 128, 512, 2048 };
+        const int numRepeats = 3;
+        const double overheadLimitPercent = 1.0;
+        bool allWithin = true;
+
+        std::cout << "Telemetry overhead at " << sampleRate << " Hz, stereo, limit " << overheadLimitPercent << "%" << std::endl;
+
+        for(int blockSize : reportBlockSizes) {
+            double nsPerSample[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+
+            for(int repeat = 0; repeat < numRepeats; repeat++) {
+                for(int enabled = 0; enabled < 2; enabled++) {
+                    OfChorusAudioProcessor processor;
+                    processor.setPlayConfigDetails(stereo, stereo, sampleRate, blockSize);
+                    processor.prepareToPlay(sampleRate, blockSize);
+                    processor.setTelemetryEnabled(enabled == 1);
+
+                    juce::MidiBuffer midi;
+                    TelemetryFrame frame;
+
+                    // Draining inside the timed block counts the editor's side too, so this is an upper bound
+                    const auto result = measure(sampleRate, blockSize, stereo, seconds, [&](juce::AudioBuffer<float>& buffer) {
+                        processor.processBlock(buffer, midi);
+
+                        while(processor.getTelemetry().pop(frame)) {
+                        }
+                    });
+
+                    nsPerSample[enabled] = juce::jmin(nsPerSample[enabled], result.nsPerSample);
+                }
+            }
+
+            const double overheadPercent = (nsPerSample[1] / nsPerSample[0] - 1.0) * 100.0;
+            const bool within = overheadPercent < overheadLimitPercent;
+
+            std::cout << "  block " << juce::String(blockSize).paddedLeft(' ', 5) << ": "
+                      << juce::String(nsPerSample[0], 2).paddedLeft(' ', 7) << " ns/sample off, "
+                      << juce::String(nsPerSample[1], 2).paddedLeft(' ', 7) << " ns/sample on, overhead "
+                      << juce::String(overheadPercent, 2).paddedLeft(' ', 6) << "%"
+                      << (within ? "" : "  over limit") << std::endl;
+
+            allWithin = allWithin && within;
+        }
+
+        return allWithin;
+    }
+
+    // Times the processor with the envelope follower off and on, the same way as the telemetry
+    void runEnvelopeReport(double seconds)
+    {
+        const double sampleRate = 48000.0;
+        const int reportBlockSizes[] = { 32, 128, 512, 2048 };
+        const int numRepeats = 3;
+
+        std::cout << "Envelope follower overhead at " << sampleRate << " Hz, stereo" << std::endl;
+
+        for(int blockSize : reportBlockSizes) {
+            double nsPerSample[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+
+            for(int repeat = 0; repeat < numRepeats; repeat++) {
+                for(int enabled = 0; enabled < 2; enabled++) {
+                    OfChorusAudioProcessor processor;
+
+                    // Any amount turns the follower on, all three make every block move depth, rate and mix
+                    setParameter(processor, "envdepth", enabled == 1 ? 0.5f : 0.0f);
+                    setParameter(processor, "envrate", enabled == 1 ? 0.5f : 0.0f);
+                    setParameter(processor, "envmix", enabled == 1 ? -0.5f : 0.0f);
+
+                    processor.setPlayConfigDetails(stereo, stereo, sampleRate, blockSize);
+                    processor.prepareToPlay(sampleRate, blockSize);
+
+                    juce::MidiBuffer midi;
+
+                    const auto result = measure(sampleRate, blockSize, stereo, seconds, [&](juce::AudioBuffer<float>& buffer) {
+                        processor.processBlock(buffer, midi);
+                    });
+
+                    nsPerSample[enabled] = juce::jmin(nsPerSample[enabled], result.nsPerSample);
+                }
+            }
+
+            const double overheadPercent = (nsPerSample[1] / nsPerSample[0] - 1.0) * 100.0;
+
+            std::cout << "  block " << juce::String(blockSize).paddedLeft(' ', 5) << ": "
+                      << juce::String(nsPerSample[0], 2).paddedLeft(' ', 7) << " ns/sample off, "
+                      << juce::String(nsPerSample[1], 2).paddedLeft(' ', 7) << " ns/sample on, overhead "
+                      << juce::String(overheadPercent, 2).paddedLeft(' ', 6) << "%" << std::endl;
+        }
+    }
+
+    // Loads a session's worth of instances and moves them through every sample rate
+    void runPoolReport(int numInstances)
+    {
+        juce::SharedResourcePointer<DelayLinePool> pool;
+        std::vector<std::unique_ptr<OfChorusAudioProcessor>> processors;
+
+        for(int i = 0; i < numInstances; i++) {
+            processors.push_back(std::make_unique<OfChorusAudioProcessor>());
+        }
+
+        std::cout << "DelayLinePool with " << numInstances << " instances" << std::endl;
+
+        for(double sampleRate : sampleRates) {
+            for(auto& processor : processors) {
+                processor->setPlayConfigDetails(stereo, stereo, sampleRate, 512);
+                processor->prepareToPlay(sampleRate, 512);
+            }
+
+            std::cout << "  " << juce::String(sampleRate, 0).paddedLeft(' ', 6) << " Hz: "
+                      << pool->getNumArenas() << " arenas, "
+                      << juce::String((double) pool->getTotalPooledBytes() / (1024.0 * 1024.0), 2) << " MB pooled, "
+                      << juce::String((double) pool->getBytesInUse() / (1024.0 * 1024.0), 2) << " MB in use" << std::endl;
+        }
+    }
+
+    // The attributes the processor wrote before it switched to the binary format
+    void getLegacyStateInformation(juce::AudioProcessor& processor, juce::MemoryBlock& destData)
+    {
+        const char* const attributes[] = { "DryWet", "Depth", "Rate", "PhaseOffset", "Feedback", "Type", "Voices", "Interpolation" };
+        const auto& parameters = processor.getParameters();
+
+        juce::XmlElement xml("FlangerChorus");
+
+        // The parameters added since then come after these and were never in the old format
+        for(int i = 0; i < (int) std::size(attributes); i++) {
+            auto* parameter = static_cast<juce::RangedAudioParameter*>(parameters.getUnchecked(i));
+            const float value = parameter->convertFrom0to1(parameter->getValue());
+
+            if(dynamic_cast<juce::AudioParameterInt*>(parameter) != nullptr) {
+                xml.setAttribute(attributes[i], juce::roundToInt(value));
+            }
+            else {
+                xml.setAttribute(attributes[i], value);
+            }
+        }
+
+        juce::AudioProcessor::copyXmlToBinary(xml, destData);
+    }
+
+    void runStateReport(int numInstances)
+    {
+        const int numRuns = 3;
+
+        std::vector<std::unique_ptr<OfChorusAudioProcessor>> processors;
+        std::vector<juce::MemoryBlock> binaryStates((size_t) numInstances);
+        std::vector<juce::MemoryBlock> legacyStates((size_t) numInstances);
+        juce::Random random(0x5eed);
+
+        for(int i = 0; i < numInstances; i++) {
+            processors.push_back(std::make_unique<OfChorusAudioProcessor>());
+
+            for(auto* parameter : processors.back()->getParameters()) {
+                parameter->setValueNotifyingHost(random.nextFloat());
+            }
+        }
+
+        // Best of a few runs of one operation over every instance, in microseconds per instance
+        auto time = [&] (auto&& operation) {
+            double best = std::numeric_limits<double>::max();
+
+            for(int run = 0; run < numRuns; run++) {
+                const auto start = std::chrono::high_resolution_clock::now();
+
+                for(int i = 0; i < numInstances; i++) {
+                    operation(*processors[(size_t) i], (size_t) i);
+                }
+
+                const auto end = std::chrono::high_resolution_clock::now();
+                best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count() / numInstances);
+            }
+
+            return best;
+        };
+
+        const double binarySave = time([&] (OfChorusAudioProcessor& processor, size_t i) {
+            processor.getStateInformation(binaryStates[i]);
+        });
+        const double legacySave = time([&] (OfChorusAudioProcessor& processor, size_t i) {
+            getLegacyStateInformation(processor, legacyStates[i]);
+        });
+
+        // Recalling into the next instance, so every load really changes the parameters
+        const double binaryLoad = time([&] (OfChorusAudioProcessor& processor, size_t i) {
+            const auto& state = binaryStates[(i + 1) % binaryStates.size()];
+            processor.setStateInformation(state.getData(), (int) state.getSize());
+        });
+
+        // Every instance now holds its neighbour's parameters, saving again must reproduce those bytes
+        int mismatches = 0;
+
+        for(size_t i = 0; i < processors.size(); i++) {
+            juce::MemoryBlock state;
+            processors[i]->getStateInformation(state);
+            mismatches += state == binaryStates[(i + 1) % binaryStates.size()] ? 0 : 1;
+        }
+
+        const double legacyLoad = time([&] (OfChorusAudioProcessor& processor, size_t i) {
+            const auto& state = legacyStates[i];
+            processor.setStateInformation(state.getData(), (int) state.getSize());
+        });
+
+        std::cout << "State save and recall over " << numInstances << " instances, best of " << numRuns << " runs" << std::endl;
+        std::cout << "  format  bytes  save us  load us" << std::endl;
+        std::cout << "  binary" << juce::String((int) binaryStates[0].getSize()).paddedLeft(' ', 7)
+                  << juce::String(binarySave, 3).paddedLeft(' ', 9)
+                  << juce::String(binaryLoad, 3).paddedLeft(' ', 9) << std::endl;
+        std::cout << "  xml   " << juce::String((int) legacyStates[0].getSize()).paddedLeft(' ', 7)
+                  << juce::String(legacySave, 3).paddedLeft(' ', 9)
+                  << juce::String(legacyLoad, 3).paddedLeft(' ', 9) << std::endl;
+        std::cout << "  " << numInstances << " instances recalled in "
+                  << juce::String(binaryLoad * numInstances / 1000.0, 2) << " ms (binary) vs "
+                  << juce::String(legacyLoad * numInstances / 1000.0, 2) << " ms (xml), "
+                  << mismatches << " round trip mismatches" << std::endl;
+    }
+
+    void printResult(const Result& result, bool csv)
+    {
+        if(csv) {
+            std::cout << result.engine << "," << result.mode << "," << result.sampleRate << "," << result.blockSize << ","
+                      << result.nsPerSample << "," << result.realTimeFactor << ","
+                      << result.p50Micros << "," << result.p99Micros << "," << result.maxMicros << std::endl;
+            return;
+        }
+
+        std::cout << juce::String(result.engine).paddedRight(' ', 24)
+                  << juce::String(result.mode).paddedRight(' ', 9)
+                  << juce::String(result.sampleRate, 0).paddedLeft(' ', 7)
+                  << juce::String(result.blockSize).paddedLeft(' ', 6)
+                  << juce::String(result.nsPerSample, 2).paddedLeft(' ', 10)
+                  << juce::String(result.realTimeFactor, 1).paddedLeft(' ', 10)
+                  << juce::String(result.p50Micros, 2).paddedLeft(' ', 11)
+                  << juce::String(result.p99Micros, 2).paddedLeft(' ', 11)
+                  << juce::String(result.maxMicros, 2).paddedLeft(' ', 11) << std::endl;
+    }
+
+    void printHeader(bool csv)
+    {
+        if(csv) {
+            std::cout << "engine,mode,sample_rate,block_size,ns_per_sample,realtime_factor,p50_us,p99_us,max_us" << std::endl;
+            return;
+        }
+
+        std::cout << juce::String("engine").paddedRight(' ', 24)
+                  << juce::String("mode").paddedRight(' ', 9)
+                  << juce::String("rate").paddedLeft(' ', 7)
+                  << juce::String("block").paddedLeft(' ', 6)
+                  << juce::String("ns/sample").paddedLeft(' ', 10)
+                  << juce::String("x rtime").paddedLeft(' ', 10)
+                  << juce::String("p50 us").paddedLeft(' ', 11)
+                  << juce::String("p99 us").paddedLeft(' ', 11)
+                  << juce::String("max us").paddedLeft(' ', 11) << std::endl;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 1.0;
+    const double onlyRate = args.containsOption("--rate") ? args.getValueForOption("--rate").getDoubleValue() : 0.0;
+    const int onlyBlock = args.containsOption("--block") ? args.getValueForOption("--block").getIntValue() : 0;
+    const int voices = args.containsOption("--voices") ? args.getValueForOption("--voices").getIntValue() : 1;
+    const int channels = args.containsOption("--channels") ? args.getValueForOption("--channels").getIntValue() : stereo;
+    const bool csv = args.containsOption("--csv");
+    const bool doublePrecision = args.containsOption("--double");
+    const int numInterpolations = args.containsOption("--interpolation") ? numInterpolationTypes : 1;
+    const bool silence = args.containsOption("--silence");
+
+    if(args.containsOption("--pool")) {
+        runPoolReport(args.containsOption("--instances") ? args.getValueForOption("--instances").getIntValue() : 500);
+        return 0;
+    }
+
+    if(args.containsOption("--state")) {
+        runStateReport(args.containsOption("--instances") ? args.getValueForOption("--instances").getIntValue() : 10000);
+        return 0;
+    }
+
+    if(args.containsOption("--telemetry")) {
+        return runTelemetryReport(args.containsOption("--seconds") ? seconds : 5.0) ? 0 : 1;
+    }
+
+    if(args.containsOption("--envelope")) {
+        runEnvelopeReport(args.containsOption("--seconds") ? seconds : 5.0);
+        return 0;
+    }
+
+    if(args.containsOption("--control")) {
+        return runControlRateReport(args.containsOption("--seconds") ? seconds : 10.0) ? 0 : 1;
+    }
+
+    if(args.containsOption("--engine")) {
+        return runEngineReport(args.containsOption("--seconds") ? seconds : 10.0) ? 0 : 1;
+    }
+
+    if(args.containsOption("--lfo")) {
+        return runLFOBenchmark(args.containsOption("--seconds") ? seconds : 3600.0) ? 0 : 1;
+    }
+
+    printHeader(csv);
+
+    for(double sampleRate : sampleRates) {
+        if(onlyRate > 0 && ! juce::exactlyEqual(sampleRate, onlyRate)) {
+            continue;
+        }
+
+        for(int blockSize : blockSizes) {
+            if(onlyBlock > 0 && blockSize != onlyBlock) {
+                continue;
+            }
+
+            for(int type = 0; type < numEffectTypes; type++) {
+                if(doublePrecision) {
+                    printResult(measureProcessorDouble(sampleRate, blockSize, channels, type, voices, seconds, true), csv);
+                    printResult(measureProcessorDouble(sampleRate, blockSize, channels, type, voices, seconds, false), csv);
+                    continue;
+                }
+
+                for(int interpolation = 0; interpolation < numInterpolations; interpolation++) {
+                    printResult(measureProcessor(sampleRate, blockSize, channels, type, voices, interpolation, seconds), csv);
+                }
+
+                if(silence) {
+                    printResult(measureProcessor(sampleRate, blockSize, channels, type, voices, (int) InterpolationType::linear, seconds, true), csv);
+                }
+
+                // The baselines only know chorus and flanger
+                if(type > (int) EffectType::flanger) {
+                    continue;
+                }
+
+                if(channels == stereo) {
+                    printResult(measureReference(sampleRate, blockSize, type, seconds), csv);
+                }
+
+                printResult(measureJuceChorus(sampleRate, blockSize, channels, type, seconds), csv);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    Real-time safety check.
+
+    Renders every combination of effect type, voice count, interpolator,
+    channel count, sample rate and sample precision with random block sizes,
+    parameter automation, a preset switch and a stretch of silence, all under
+    RealtimeGuard. Any allocation, mutex lock or blocking system call made
+    inside processBlock is printed with its stack trace and fails the run, so
+    this can gate a build before a change causes dropouts.
+
+    This target is always compiled with OF_CHORUS_REALTIME_CHECKS. The
+    interceptors need Linux; on other platforms the run only exercises the
+    combinations.
+
+    Usage: OfChorusRealtimeCheck [--seconds <s>] [--seed <n>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "RealtimeGuard.h"
+
+#include <iostream>
+
+namespace
+{
+    const double sampleRates[] = { 44100.0, 96000.0 };
+    const int channelCounts[] = { 1, 2 };
+    const int maxBlockSize = 2048;
+
+    // Parameter indices, in the order the processor adds them
+    enum ParameterIndex
+    {
+        dryWetIndex = 0,
+        depthIndex,
+        rateIndex,
+        phaseOffsetIndex,
+        feedbackIndex,
+        typeIndex,
+        voicesIndex,
+        interpolationIndex,
+        envelopeAttackIndex,
+        envelopeReleaseIndex,
+        envelopeDetectorIndex,
+        envelopeDepthIndex,
+        envelopeRateIndex,
+        envelopeMixIndex
+    };
+
+    struct Combination
+    {
+        int type;
+        int voices;
+        int interpolation;
+        int numChannels;
+        double sampleRate;
+        bool doublePrecision;
+
+        juce::String getDescription() const
+        {
+            return getEffectTypeNames()[type].toLowerCase()
+                + ", " + juce::String(voices) + " voices"
+                + ", " + getInterpolationTypeNames()[interpolation].toLowerCase()
+                + ", " + juce::String(numChannels) + " ch"
+                + ", " + juce::String(sampleRate, 0) + " Hz"
+                + ", " + (doublePrecision ? "double" : "float");
+        }
+    };
+
+    // The first trace of the current combination, filled in by the violation handler
+    juce::String firstViolation;
+
+    void recordViolation(const char* call, const juce::String& stackTrace)
+    {
+        if(firstViolation.isEmpty()) {
+            firstViolation = juce::String(call) + "\n" + stackTrace;
+        }
+    }
+
+    void setParameter(juce::AudioProcessor& processor, int index, float value)
+    {
+        auto* parameter = static_cast<juce::RangedAudioParameter*>(processor.getParameters().getUnchecked(index));
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    template <typename SampleType>
+    void render(OfChorusAudioProcessor& processor, juce::AudioBuffer<SampleType>& buffer, juce::Random& random, int numSamples, bool silent)
+    {
+        juce::MidiBuffer midi;
+
+        for(int done = 0; done < numSamples; ) {
+            const int blockSize = juce::jmin(numSamples - done, 1 + random.nextInt(maxBlockSize));
+
+            buffer.setSize(buffer.getNumChannels(), blockSize, false, false, true);
+
+            for(int channel = 0; channel < buffer.getNumChannels(); channel++) {
+                SampleType* samples = buffer.getWritePointer(channel);
+
+                for(int i = 0; i < blockSize; i++) {
+                    samples[i] = silent ? (SampleType) 0 : (SampleType) (random.nextFloat() * 2.0f - 1.0f);
+                }
+            }
+
+            // Automating between blocks, the way a host thread would
+            if(! silent && random.nextInt(4) == 0) {
+                const int index = random.nextInt(feedbackIndex + 1);
+                processor.getParameters().getUnchecked(index)->setValueNotifyingHost(random.nextFloat());
+            }
+
+            processor.processBlock(buffer, midi);
+            done += blockSize;
+        }
+    }
+
+    template <typename SampleType>
+    void runCombination(const Combination& combination, double seconds, juce::Random& random)
+    {
+        OfChorusAudioProcessor processor;
+
+        setParameter(processor, typeIndex, (float) combination.type);
+        setParameter(processor, voicesIndex, (float) combination.voices);
+        setParameter(processor, interpolationIndex, (float) combination.interpolation);
+
+        // Following the envelope too, it reads the input on the audio thread, with both detectors across the interpolators
+        setParameter(processor, envelopeDetectorIndex, (float) (combination.interpolation % numEnvelopeDetectors));
+        setParameter(processor, envelopeDepthIndex, 0.5f);
+        setParameter(processor, envelopeRateIndex, 0.5f);
+        setParameter(processor, envelopeMixIndex, -0.5f);
+
+        processor.setPlayConfigDetails(combination.numChannels, combination.numChannels, combination.sampleRate, maxBlockSize);
+        processor.prepareToPlay(combination.sampleRate, maxBlockSize);
+        processor.setTelemetryEnabled(true);
+
+        juce::AudioBuffer<SampleType> buffer(combination.numChannels, maxBlockSize);
+        const int numSamples = (int) (seconds * combination.sampleRate);
+
+        render(processor, buffer, random, numSamples, false);
+
+        // Crossfading to a preset and back to the combination's modes
+        processor.setCurrentProgram(random.nextInt(processor.getNumPrograms()));
+        render(processor, buffer, random, numSamples, false);
+
+        setParameter(processor, typeIndex, (float) combination.type);
+        setParameter(processor, voicesIndex, (float) combination.voices);
+        setParameter(processor, interpolationIndex, (float) combination.interpolation);
+        render(processor, buffer, random, numSamples, false);
+
+        // Letting the tail die away so the kernel goes idle, then waking it up again
+        setParameter(processor, feedbackIndex, 0.0f);
+        render(processor, buffer, random, numSamples, false);
+        render(processor, buffer, random, numSamples + (int) (processor.getTailLengthSeconds() * combination.sampleRate), true);
+        render(processor, buffer, random, numSamples, false);
+
+        processor.releaseResources();
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 0.1;
+    juce::Random random(args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 0x5eed);
+
+   #if ! JUCE_LINUX
+    std::cout << "Warning: the interceptors only exist on Linux, nothing is checked on this platform" << std::endl;
+   #endif
+
+    RealtimeGuard::setViolationHandler(recordViolation);
+
+    int numCombinations = 0;
+    int numFailures = 0;
+
+    for(double sampleRate : sampleRates) {
+        for(int numChannels : channelCounts) {
+            for(int type = 0; type < numEffectTypes; type++) {
+                for(int voices = 1; voices <= ChorusKernel::maxVoices; voices++) {
+                    for(int interpolation = 0; interpolation < numInterpolationTypes; interpolation++) {
+                        for(bool doublePrecision : { false, true }) {
+                            const Combination combination { type, voices, interpolation, numChannels, sampleRate, doublePrecision };
+
+                            RealtimeGuard::resetNumViolations();
+                            firstViolation.clear();
+
+                            if(doublePrecision) {
+                                runCombination<double>(combination, seconds, random);
+                            }
+                            else {
+                                runCombination<float>(combination, seconds, random);
+                            }
+
+                            numCombinations++;
+
+                            if(RealtimeGuard::getNumViolations() > 0) {
+                                numFailures++;
+                                std::cout << "FAIL " << combination.getDescription() << ": "
+                                          << RealtimeGuard::getNumViolations() << " violations, first: " << firstViolation << std::endl;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << numCombinations - numFailures << " of " << numCombinations << " combinations real-time safe" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    ReferenceChorus.h
+
+    The original two-channel scalar processBlock loop, kept as a reference for
+    the benchmark so every optimisation can be compared against it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusKernel.h"
+
+//==============================================================================
+/**
+*/
+class ReferenceChorus
+{
+public:
+    void prepare(double sampleRate)
+    {
+        mSampleRate = sampleRate;
+        mCircularBufferLength = (int) (sampleRate * 2);
+
+        mCircularBufferLeft.assign((size_t) mCircularBufferLength, 0.0f);
+        mCircularBufferRight.assign((size_t) mCircularBufferLength, 0.0f);
+
+        mCircularBufferWriteHead = 0;
+        mLFOPhase = 0;
+        mFeedbackLeft = 0;
+        mFeedbackRight = 0;
+    }
+
+    void process(juce::AudioBuffer<float>& buffer, const ChorusKernel::Parameters& parameters)
+    {
+        float* leftChannel = buffer.getWritePointer(0);
+        float* rightChannel = buffer.getWritePointer(1);
+
+        for(int i = 0; i < buffer.getNumSamples(); i++) {
+            mCircularBufferLeft[mCircularBufferWriteHead] = leftChannel[i] + mFeedbackLeft;
+            mCircularBufferRight[mCircularBufferWriteHead] = rightChannel[i] + mFeedbackRight;
+
+            float lfoOutLeft = sin(2 * M_PI * mLFOPhase);
+            lfoOutLeft *= parameters.depth;
+
+            float lfoPhaseRight = mLFOPhase + parameters.phaseOffset;
+
+            if(lfoPhaseRight > 1) {
+                lfoPhaseRight -= 1;
+            }
+
+            float lfoOutRight = sin(2 * M_PI * lfoPhaseRight);
+            lfoOutRight *= parameters.depth;
+
+            mLFOPhase += parameters.rate / mSampleRate;
+
+            const float minDelay = parameters.type == 0 ? 0.005f : 0.001f;
+            const float maxDelay = parameters.type == 0 ? 0.03f : 0.005f;
+
+            float delayTimeSamplesLeft = mSampleRate * juce::jmap<float>(lfoOutLeft, -1.f, 1.f, minDelay, maxDelay);
+            float delayTimeSamplesRight = mSampleRate * juce::jmap<float>(lfoOutRight, -1.f, 1.f, minDelay, maxDelay);
+
+            if(mLFOPhase > 1) {
+                mLFOPhase -= 1;
+            }
+
+            float delay_sample_left = readDelay(mCircularBufferLeft, delayTimeSamplesLeft);
+            float delay_sample_right = readDelay(mCircularBufferRight, delayTimeSamplesRight);
+
+            mFeedbackLeft = delay_sample_left * parameters.feedback;
+            mFeedbackRight = delay_sample_right * parameters.feedback;
+
+            mCircularBufferWriteHead++;
+
+            if(mCircularBufferWriteHead >= mCircularBufferLength) {
+                mCircularBufferWriteHead = 0;
+            }
+
+            float dryAmount = 1 - parameters.dryWet;
+            float wetAmount = parameters.dryWet;
+
+            leftChannel[i] = leftChannel[i] * dryAmount + delay_sample_left * wetAmount;
+            rightChannel[i] = rightChannel[i] * dryAmount + delay_sample_right * wetAmount;
+        }
+    }
+
+private:
+    float readDelay(const std::vector<float>& circularBuffer, float delayTimeSamples) const
+    {
+        float delayReadHead = mCircularBufferWriteHead - delayTimeSamples;
+
+        if(delayReadHead < 0) {
+            delayReadHead += mCircularBufferLength;
+        }
+
+        int readHead_x = (int) delayReadHead;
+        int readHead_x1 = readHead_x + 1;
+        float readHeadFloat = delayReadHead - readHead_x;
+
+        if(readHead_x1 >= mCircularBufferLength) {
+            readHead_x1 -= mCircularBufferLength;
+        }
+
+        return (1 - readHeadFloat) * circularBuffer[(size_t) readHead_x] + readHeadFloat * circularBuffer[(size_t) readHead_x1];
+    }
+
+    double mSampleRate = 44100.0;
+
+    float mLFOPhase = 0;
+    float mFeedbackLeft = 0;
+    float mFeedbackRight = 0;
+
+    int mCircularBufferWriteHead = 0;
+    int mCircularBufferLength = 0;
+
+    std::vector<float> mCircularBufferLeft;
+    std::vector<float> mCircularBufferRight;
+};
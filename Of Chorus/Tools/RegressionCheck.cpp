@@ -0,0 +1,436 @@
+/*
+  ==============================================================================
+
+    Golden output regression check.
+
+    Renders an impulse, a sine sweep and noise through OfChorusAudioProcessor
+    for every effect type at a set of parameter corners, voices, interpolators
+    and envelope amounts included. Each render is compared against a golden
+    render stored from the processor itself, within an error budget on the
+    maximum absolute error and the signal to error ratio that only leaves room
+    for rounding. Where the original two channel loop in ReferenceChorus.h can
+    play a corner, the render also has to stay close to its stored output.
+    Every render is repeated in blocks of 1, 64 and 4096 samples, which have to
+    agree with each other to float rounding.
+
+    Renders are 32 bit float WAV files, the golden ones in Tools/References/Golden
+    and the original loop's in Tools/References. --record writes the golden
+    renders again from the build under test, after a change to the output was
+    meant. --record-reference writes the original loop's again from
+    ReferenceChorus, so they only change when the reference itself does.
+
+    Usage: OfChorusRegression [--record] [--record-reference] [--references <dir>] [--verbose]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ReferenceChorus.h"
+
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#ifndef OF_CHORUS_REFERENCE_DIR
+ #define OF_CHORUS_REFERENCE_DIR "References"
+#endif
+
+namespace
+{
+    const double sampleRate = 48000.0;
+    const int stereo = 2;
+    const int numSamples = 8192;
+
+    // The largest block size is compared against the references, the others against it
+    const int blockSizes[] = { 4096, 64, 1 };
+
+    // ReferenceChorus only knows the chorus and flanger delay ranges
+    const int numReferenceTypes = 2;
+
+    // Parameter indices, in the order the processor adds them
+    enum ParameterIndex
+    {
+        dryWetIndex = 0,
+        depthIndex,
+        rateIndex,
+        phaseOffsetIndex,
+        feedbackIndex,
+        typeIndex,
+        voicesIndex,
+        interpolationIndex,
+        envelopeAttackIndex,
+        envelopeReleaseIndex,
+        envelopeDetectorIndex,
+        envelopeDepthIndex,
+        envelopeRateIndex,
+        envelopeMixIndex
+    };
+
+    /** How far a render may stray from what it is compared with. */
+    struct ErrorBudget
+    {
+        double maxAbsError;
+        double minSignalToErrorDecibels;
+    };
+
+    // Against its golden render only rounding may differ. Another compiler may contract or reorder the
+    // delay arithmetic, and a few ulps of a delay of hundreds of samples move noise by up to about 7e-4.
+    const ErrorBudget goldenBudget { 1.0e-3, 70.0 };
+
+    // Against the original loop the delays follow control rate ramps and the LFO is a different oscillator,
+    // which below the fastest rate stays within about 0.045 of it
+    const ErrorBudget referenceBudget { 5.0e-2, 25.0 };
+
+    // The original accumulates its LFO phase in float, which at the fastest rate drifts
+    // by up to half a sample of delay over a render and leaves about 0.11 on noise
+    const ErrorBudget fastLFOReferenceBudget { 1.5e-1, 18.0 };
+
+    // The kernel counts its chunks and control points from the reset, so the parameters
+    // being static, only float rounding may differ between block sizes
+    const ErrorBudget blockSizeBudget { 1.0e-5, 70.0 };
+
+    struct Corner
+    {
+        juce::String name;
+        int parameterIndex;
+        float normalisedValue;
+
+        // Corners the original loop can also play are checked against its output within this budget
+        const ErrorBudget* referenceBudget = nullptr;
+    };
+
+    struct Comparison
+    {
+        double maxAbsError;
+        double signalToErrorDecibels;
+
+        bool isWithin(const ErrorBudget& budget) const
+        {
+            return maxAbsError <= budget.maxAbsError && signalToErrorDecibels >= budget.minSignalToErrorDecibels;
+        }
+
+        juce::String getDescription() const
+        {
+            return "max abs error " + juce::String(maxAbsError, 7) + ", SNR " + juce::String(signalToErrorDecibels, 1) + " dB";
+        }
+    };
+
+    //==============================================================================
+    /** Each corner moves one parameter to an end of its range, everything else keeps its default. */
+    std::vector<Corner> getCorners()
+    {
+        std::vector<Corner> corners;
+
+        corners.push_back({ "default", -1, 0.0f, &referenceBudget });
+        corners.push_back({ "dry", dryWetIndex, 0.0f, &referenceBudget });
+        corners.push_back({ "wet", dryWetIndex, 1.0f, &referenceBudget });
+        corners.push_back({ "depth-min", depthIndex, 0.0f, &referenceBudget });
+        corners.push_back({ "depth-max", depthIndex, 1.0f, &referenceBudget });
+        corners.push_back({ "rate-min", rateIndex, 0.0f, &referenceBudget });
+        corners.push_back({ "rate-max", rateIndex, 1.0f, &fastLFOReferenceBudget });
+        corners.push_back({ "phase-half", phaseOffsetIndex, 0.5f, &referenceBudget });
+        corners.push_back({ "feedback-min", feedbackIndex, 0.0f, &referenceBudget });
+        corners.push_back({ "feedback-max", feedbackIndex, 1.0f, &referenceBudget });
+
+        // The original loop has a single voice and linear interpolation
+        corners.push_back({ "voices-max", voicesIndex, 1.0f });
+
+        for(int interpolation = 1; interpolation < numInterpolationTypes; interpolation++) {
+            corners.push_back({ "interpolation-" + getInterpolationTypeNames()[interpolation].toLowerCase(), interpolationIndex,
+                                (float) interpolation / (float) (numInterpolationTypes - 1) });
+        }
+
+        // The amounts are -1 to 1, so these push depth and rate up and the mix down with the input level
+        corners.push_back({ "envelope-depth", envelopeDepthIndex, 1.0f });
+        corners.push_back({ "envelope-rate", envelopeRateIndex, 1.0f });
+        corners.push_back({ "envelope-mix", envelopeMixIndex, 0.0f });
+
+        return corners;
+    }
+
+    void fillSignal(juce::AudioBuffer<float>& buffer, const juce::String& signal)
+    {
+        buffer.setSize(stereo, numSamples);
+        buffer.clear();
+
+        juce::Random random(0x5eed);
+
+        for(int channel = 0; channel < stereo; channel++) {
+            float* samples = buffer.getWritePointer(channel);
+
+            if(signal == "impulse") {
+                samples[0] = 1.0f;
+            }
+            else if(signal == "sweep") {
+                // Exponential sweep from 20 Hz to 20 kHz over the whole render
+                const double startFrequency = 20.0;
+                const double sweepRate = std::log(20000.0 / startFrequency) / numSamples;
+
+                for(int i = 0; i < numSamples; i++) {
+                    const double phase = juce::MathConstants<double>::twoPi * startFrequency / sampleRate * (std::exp(sweepRate * i) - 1.0) / sweepRate;
+                    samples[i] = 0.5f * (float) std::sin(phase);
+                }
+            }
+            else {
+                for(int i = 0; i < numSamples; i++) {
+                    samples[i] = 0.5f * (random.nextFloat() * 2.0f - 1.0f);
+                }
+            }
+        }
+    }
+
+    void setCorner(OfChorusAudioProcessor& processor, int type, const Corner& corner)
+    {
+        const auto& parameters = processor.getParameters();
+
+        auto* typeParameter = static_cast<juce::RangedAudioParameter*>(parameters.getUnchecked(typeIndex));
+        typeParameter->setValueNotifyingHost(typeParameter->convertTo0to1((float) type));
+
+        if(corner.parameterIndex >= 0) {
+            parameters.getUnchecked(corner.parameterIndex)->setValueNotifyingHost(corner.normalisedValue);
+        }
+    }
+
+    void render(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output, int type, const Corner& corner, int blockSize)
+    {
+        OfChorusAudioProcessor processor;
+        setCorner(processor, type, corner);
+
+        processor.setPlayConfigDetails(stereo, stereo, sampleRate, blockSize);
+        processor.setNonRealtime(true);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        output.makeCopyOf(input);
+
+        juce::AudioBuffer<float> block;
+        juce::MidiBuffer midi;
+
+        // Rendering in place through a buffer that refers to the output, the way a host hands out its buffers
+        for(int start = 0; start < numSamples; start += blockSize) {
+            const int length = juce::jmin(blockSize, numSamples - start);
+
+            block.setDataToReferTo(output.getArrayOfWritePointers(), stereo, start, length);
+            processor.processBlock(block, midi);
+        }
+
+        processor.releaseResources();
+    }
+
+    void renderReference(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output, int type, const Corner& corner)
+    {
+        // Taking the plain values from the processor's parameters, so the corners mean the same to both
+        OfChorusAudioProcessor processor;
+        setCorner(processor, type, corner);
+
+        const auto& parameters = processor.getParameters();
+        const auto getValue = [&parameters](int index) {
+            const auto* parameter = static_cast<juce::RangedAudioParameter*>(parameters.getUnchecked(index));
+            return parameter->convertFrom0to1(parameter->getValue());
+        };
+
+        ChorusKernel::Parameters snapshot;
+        snapshot.dryWet = getValue(dryWetIndex);
+        snapshot.depth = getValue(depthIndex);
+        snapshot.rate = getValue(rateIndex);
+        snapshot.phaseOffset = getValue(phaseOffsetIndex);
+        snapshot.feedback = getValue(feedbackIndex);
+        snapshot.type = juce::roundToInt(getValue(typeIndex));
+        snapshot.voices = 1;
+        snapshot.interpolation = 0;
+
+        ReferenceChorus reference;
+        reference.prepare(sampleRate);
+
+        output.makeCopyOf(input);
+        reference.process(output, snapshot);
+    }
+
+    Comparison compare(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual)
+    {
+        double maxAbsError = 0;
+        double errorSquares = 0;
+        double signalSquares = 0;
+
+        for(int channel = 0; channel < stereo; channel++) {
+            const float* expectedSamples = expected.getReadPointer(channel);
+            const float* actualSamples = actual.getReadPointer(channel);
+
+            for(int i = 0; i < numSamples; i++) {
+                const double error = (double) actualSamples[i] - expectedSamples[i];
+
+                // Once NaN gets in it sticks, and fails every comparison with the budget
+                maxAbsError = std::isnan(error) ? error : juce::jmax(maxAbsError, std::abs(error));
+                errorSquares += error * error;
+                signalSquares += juce::square((double) expectedSamples[i]);
+            }
+        }
+
+        // A silent reference only matches silence
+        const double signalToError = juce::exactlyEqual(errorSquares, 0.0) ? 1.0e10 : std::sqrt(juce::jmax(signalSquares, 1.0e-30) / errorSquares);
+
+        return { maxAbsError, juce::Decibels::gainToDecibels(signalToError, -200.0) };
+    }
+
+    /** Notes the comparison if it is over the budget, or always when verbose, and returns whether it is within. */
+    bool check(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual, const ErrorBudget& budget,
+               const juce::String& label, bool verbose, juce::StringArray& lines)
+    {
+        const auto comparison = compare(expected, actual);
+        const bool within = comparison.isWithin(budget);
+
+        if(! within || verbose) {
+            lines.add(label + ": " + comparison.getDescription());
+        }
+
+        return within;
+    }
+
+    //==============================================================================
+    bool writeReference(const juce::File& file, const juce::AudioBuffer<float>& buffer)
+    {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+        if(stream->failedToOpen()) {
+            return false;
+        }
+
+        // JUCE writes 32 bit WAV as IEEE float, so the references keep every bit of the output
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate, (unsigned int) stereo, 32, {}, 0));
+
+        if(writer == nullptr) {
+            return false;
+        }
+
+        stream.release();
+        return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    }
+
+    bool readReference(const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatReader> reader(format.createReaderFor(new juce::FileInputStream(file), true));
+
+        if(reader == nullptr || reader->numChannels != (unsigned int) stereo || reader->lengthInSamples != numSamples) {
+            return false;
+        }
+
+        buffer.setSize(stereo, numSamples);
+        return reader->read(&buffer, 0, numSamples, 0, true, true);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const bool record = args.containsOption("--record");
+    const bool recordReference = args.containsOption("--record-reference");
+    const bool verbose = args.containsOption("--verbose");
+    const auto referenceDirectory = args.containsOption("--references")
+        ? juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--references"))
+        : juce::File::getCurrentWorkingDirectory().getChildFile(OF_CHORUS_REFERENCE_DIR);
+    const auto goldenDirectory = referenceDirectory.getChildFile("Golden");
+
+    if((record && goldenDirectory.createDirectory().failed()) || (recordReference && referenceDirectory.createDirectory().failed())) {
+        std::cerr << "Cannot create " << (record ? goldenDirectory : referenceDirectory).getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // Taking the types from the parameter's range, so new types are covered as soon as they exist
+    OfChorusAudioProcessor processor;
+    const auto* typeParameter = static_cast<juce::RangedAudioParameter*>(processor.getParameters().getUnchecked(typeIndex));
+    const int numTypes = (int) typeParameter->getNormalisableRange().end + 1;
+
+    const auto corners = getCorners();
+    const juce::StringArray signals { "impulse", "sweep", "noise" };
+
+    std::cout << (record ? "Recording" : "Checking") << " golden renders in " << goldenDirectory.getFullPathName() << std::endl;
+    std::cout << (recordReference ? "Recording" : "Checking") << " references in " << referenceDirectory.getFullPathName() << std::endl;
+    std::cout << "Budgets: max abs error " << goldenBudget.maxAbsError << " and SNR " << goldenBudget.minSignalToErrorDecibels
+              << " dB against the golden renders, max abs error " << referenceBudget.maxAbsError << " and SNR " << referenceBudget.minSignalToErrorDecibels
+              << " dB against the references (" << fastLFOReferenceBudget.maxAbsError << " and " << fastLFOReferenceBudget.minSignalToErrorDecibels
+              << " dB at the fastest rate), max abs error " << blockSizeBudget.maxAbsError << " and SNR "
+              << blockSizeBudget.minSignalToErrorDecibels << " dB between block sizes" << std::endl;
+
+    int numRenders = 0;
+    int numFailures = 0;
+
+    juce::AudioBuffer<float> input;
+    juce::AudioBuffer<float> rendered;
+    juce::AudioBuffer<float> output;
+    juce::AudioBuffer<float> stored;
+
+    for(int type = 0; type < numTypes; type++) {
+        for(const auto& corner : corners) {
+            for(const auto& signal : signals) {
+                const juce::String name = getEffectTypeNames()[type].toLowerCase() + "-" + corner.name + "-" + signal;
+                const auto goldenFile = goldenDirectory.getChildFile(name + ".wav");
+                const auto referenceFile = referenceDirectory.getChildFile(name + ".wav");
+                const bool hasReference = corner.referenceBudget != nullptr && type < numReferenceTypes;
+                juce::StringArray lines;
+                bool failed = false;
+
+                fillSignal(input, signal);
+                render(input, rendered, type, corner, blockSizes[0]);
+
+                if(record) {
+                    if(! writeReference(goldenFile, rendered)) {
+                        lines.add("cannot write " + goldenFile.getFullPathName());
+                        failed = true;
+                    }
+                }
+                else if(! readReference(goldenFile, stored)) {
+                    lines.add("no usable golden render, run with --record to write it from this build");
+                    failed = true;
+                }
+                else {
+                    failed = ! check(stored, rendered, goldenBudget, "golden", verbose, lines) || failed;
+                }
+
+                // Still close to the original loop, wherever it can play the corner
+                if(hasReference && recordReference) {
+                    renderReference(input, stored, type, corner);
+
+                    if(! writeReference(referenceFile, stored)) {
+                        lines.add("cannot write " + referenceFile.getFullPathName());
+                        failed = true;
+                    }
+                }
+                else if(hasReference && ! readReference(referenceFile, stored)) {
+                    lines.add("no usable reference, run with --record-reference to write it from ReferenceChorus");
+                    failed = true;
+                }
+                else if(hasReference) {
+                    failed = ! check(stored, rendered, *corner.referenceBudget, "reference", verbose, lines) || failed;
+                }
+
+                // Every other block size has to agree with the largest one
+                for(size_t i = 1; i < std::size(blockSizes); i++) {
+                    render(input, output, type, corner, blockSizes[i]);
+                    failed = ! check(rendered, output, blockSizeBudget, "blocks of " + juce::String(blockSizes[i]), verbose, lines) || failed;
+                }
+
+                numRenders++;
+                numFailures += failed ? 1 : 0;
+
+                if(failed || verbose) {
+                    std::cout << (failed ? "FAIL " : "  ok ") << name << std::endl;
+
+                    for(const auto& line : lines) {
+                        std::cout << "       " << line << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << numRenders - numFailures << " of " << numRenders << " renders within budget" << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    Multi-instance stress harness.
+
+    Creates many OfChorusAudioProcessor instances and drives them from a pool
+    of worker threads at once, the way a host spreads a session over its audio
+    threads. Every block has a random size, and a separate host thread keeps
+    automating parameters, switching presets, saving state and draining the
+    telemetry of random instances while they render.
+
+    The run is repeated with 1, 2, 4... worker threads and the aggregate
+    throughput is reported against the thread count. Instances that shared
+    state, or cache lines, with each other would show up as throughput that
+    stops scaling. Built with -DOF_CHORUS_SANITIZE_THREAD=ON the same run checks
+    for data races under ThreadSanitizer.
+
+    Usage: OfChorusStress [--instances <n>] [--threads <n>] [--seconds <s>] [--seed <n>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    const double sampleRate = 48000.0;
+    const int maxBlockSize = 1024;
+    const int stereo = 2;
+
+    struct Instance
+    {
+        std::unique_ptr<OfChorusAudioProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+    };
+
+    //==============================================================================
+    /** Renders its share of the instances until told to stop, counting the samples it processed. */
+    class RenderWorker  : public juce::ThreadPoolJob
+    {
+    public:
+        RenderWorker(std::vector<Instance*> instances, juce::int64 seed, std::atomic<bool>& running)
+            : juce::ThreadPoolJob("Render worker"), mInstances(std::move(instances)), mRandom(seed), mRunning(running)
+        {
+            mNumSamples = 0;
+            mNumBadSamples = 0;
+        }
+
+        JobStatus runJob() override
+        {
+            // Preparing here, so instances allocate their delay lines from several threads at once
+            for(auto* instance : mInstances) {
+                instance->processor->setPlayConfigDetails(stereo, stereo, sampleRate, maxBlockSize);
+                instance->processor->prepareToPlay(sampleRate, maxBlockSize);
+                instance->processor->setTelemetryEnabled(true);
+            }
+
+            juce::MidiBuffer midi;
+
+            while(mRunning.load(std::memory_order_relaxed) && ! shouldExit()) {
+                for(auto* instance : mInstances) {
+                    const int numSamples = 1 + mRandom.nextInt(maxBlockSize);
+                    auto& buffer = instance->buffer;
+
+                    buffer.setSize(stereo, numSamples, false, false, true);
+
+                    for(int channel = 0; channel < stereo; channel++) {
+                        float* samples = buffer.getWritePointer(channel);
+
+                        for(int i = 0; i < numSamples; i++) {
+                            samples[i] = mRandom.nextFloat() * 2.0f - 1.0f;
+                        }
+                    }
+
+                    instance->processor->processBlock(buffer, midi);
+
+                    mNumSamples += numSamples;
+                    mNumBadSamples += countBadSamples(buffer);
+                }
+            }
+
+            for(auto* instance : mInstances) {
+                instance->processor->releaseResources();
+            }
+
+            return jobHasFinished;
+        }
+
+        juce::int64 getNumSamples() const { return mNumSamples; }
+        juce::int64 getNumBadSamples() const { return mNumBadSamples; }
+
+    private:
+        static int countBadSamples(const juce::AudioBuffer<float>& buffer)
+        {
+            int bad = 0;
+
+            // Feedback near 1 may ring loudly, but never blows up to infinity or NaN
+            for(int channel = 0; channel < buffer.getNumChannels(); channel++) {
+                const float* samples = buffer.getReadPointer(channel);
+
+                for(int i = 0; i < buffer.getNumSamples(); i++) {
+                    bad += std::isfinite(samples[i]) ? 0 : 1;
+                }
+            }
+
+            return bad;
+        }
+
+        std::vector<Instance*> mInstances;
+        juce::Random mRandom;
+        std::atomic<bool>& mRunning;
+
+        juce::int64 mNumSamples;
+        juce::int64 mNumBadSamples;
+    };
+
+    //==============================================================================
+    /** What a host's message and automation threads do to running instances. */
+    void driveHost(std::vector<Instance>& instances, juce::Random& random)
+    {
+        auto& instance = instances[(size_t) random.nextInt((int) instances.size())];
+        auto& processor = *instance.processor;
+        const auto& parameters = processor.getParameters();
+
+        switch(random.nextInt(8)) {
+            case 0: {
+                processor.setCurrentProgram(random.nextInt(processor.getNumPrograms()));
+                break;
+            }
+            case 1: {
+                juce::MemoryBlock state;
+                processor.getStateInformation(state);
+                processor.setStateInformation(state.getData(), (int) state.getSize());
+                break;
+            }
+            case 2: {
+                TelemetryFrame frame;
+
+                while(processor.getTelemetry().pop(frame)) {
+                }
+
+                break;
+            }
+            default: {
+                auto* parameter = parameters.getUnchecked(random.nextInt(parameters.size()));
+
+                parameter->beginChangeGesture();
+                parameter->setValueNotifyingHost(random.nextFloat());
+                parameter->endChangeGesture();
+                break;
+            }
+        }
+    }
+
+    struct RunResult
+    {
+        double realTimeFactor;
+        juce::int64 numBadSamples;
+    };
+
+    RunResult run(std::vector<Instance>& instances, int numThreads, double seconds, juce::int64 seed)
+    {
+        std::atomic<bool> running { true };
+        std::vector<std::unique_ptr<RenderWorker>> workers;
+        double elapsed;
+
+        {
+            juce::ThreadPool pool(numThreads);
+
+            // Dealing the instances out round robin, each worker owns its share exclusively
+            for(int thread = 0; thread < numThreads; thread++) {
+                std::vector<Instance*> share;
+
+                for(size_t i = (size_t) thread; i < instances.size(); i += (size_t) numThreads) {
+                    share.push_back(&instances[i]);
+                }
+
+                workers.push_back(std::make_unique<RenderWorker>(std::move(share), seed + thread, running));
+                pool.addJob(workers.back().get(), false);
+            }
+
+            // The main thread plays the host's message and automation threads meanwhile
+            juce::Random random(seed);
+            const auto start = std::chrono::high_resolution_clock::now();
+
+            while(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() < seconds) {
+                driveHost(instances, random);
+                juce::Thread::sleep(1);
+            }
+
+            running = false;
+
+            while(pool.getNumJobs() > 0) {
+                juce::Thread::sleep(1);
+            }
+
+            elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        RunResult result { 0.0, 0 };
+        juce::int64 numSamples = 0;
+
+        for(const auto& worker : workers) {
+            numSamples += worker->getNumSamples();
+            result.numBadSamples += worker->getNumBadSamples();
+        }
+
+        result.realTimeFactor = (double) numSamples / sampleRate / elapsed;
+        return result;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const int numInstances = args.containsOption("--instances") ? juce::jmax(1, args.getValueForOption("--instances").getIntValue()) : 64;
+    const int maxThreads = args.containsOption("--threads") ? juce::jmax(1, args.getValueForOption("--threads").getIntValue())
+                                                            : juce::SystemStats::getNumCpus();
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+    const juce::int64 seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 0x5eed;
+
+    std::vector<Instance> instances((size_t) numInstances);
+
+    for(auto& instance : instances) {
+        instance.processor = std::make_unique<OfChorusAudioProcessor>();
+        instance.buffer.setSize(stereo, maxBlockSize);
+    }
+
+    std::cout << numInstances << " instances, random blocks of 1 to " << maxBlockSize << " samples at "
+              << juce::String(sampleRate, 0) << " Hz, " << juce::String(seconds, 1) << " s per run" << std::endl;
+    std::cout << "threads   x rtime   per thread   efficiency   bad samples" << std::endl;
+
+    double singleThreadRate = 0;
+    juce::int64 totalBadSamples = 0;
+
+    for(int numThreads = 1; ; numThreads = juce::jmin(numThreads * 2, maxThreads)) {
+        const auto result = run(instances, numThreads, seconds, seed);
+
+        if(numThreads == 1) {
+            singleThreadRate = result.realTimeFactor;
+        }
+
+        totalBadSamples += result.numBadSamples;
+
+        // 100% means n threads render exactly n times as much audio as one
+        std::cout << juce::String(numThreads).paddedLeft(' ', 7)
+                  << juce::String(result.realTimeFactor, 1).paddedLeft(' ', 10)
+                  << juce::String(result.realTimeFactor / numThreads, 1).paddedLeft(' ', 13)
+                  << (juce::String(100.0 * result.realTimeFactor / (singleThreadRate * numThreads), 1) + "%").paddedLeft(' ', 13)
+                  << juce::String(result.numBadSamples).paddedLeft(' ', 14) << std::endl;
+
+        if(numThreads == maxThreads) {
+            break;
+        }
+    }
+
+    return totalBadSamples == 0 ? 0 : 1;
+}